@@ -4,11 +4,14 @@
 
 #include <benchmark/benchmark.h>
 
+#include "dtree/algos/categorical.h"
+#include "dtree/algos/multi_numeric.h"
 #include "dtree/algos/single_numeric.h"
 #include "dtree/impurity_measures.h"
 #include "dtree/labels.h"
 
-template <typename algo_t> void BM_algo(benchmark::State& state)
+template <typename algo_t, typename cost_fn_t>
+void BM_algo_with(benchmark::State& state, algo_t algo, cost_fn_t cost_fn)
 {
     using namespace dtree;
 
@@ -26,19 +29,195 @@ template <typename algo_t> void BM_algo(benchmark::State& state)
         labels.push_back(l_dist(gen));
     }
 
-    algo_t algo;
-
     for (auto _ : state) {
-        auto out = algo(feature, labels, gini_index);
+        auto out = algo(feature, labels, cost_fn);
+        benchmark::DoNotOptimize(out);
     }
 }
 
+template <typename algo_t, typename cost_fn_t>
+void BM_algo_cost_fn(benchmark::State& state, cost_fn_t cost_fn)
+{
+    BM_algo_with(state, algo_t {}, cost_fn);
+}
+
+template <typename algo_t> void BM_algo(benchmark::State& state)
+{
+    BM_algo_cost_fn<algo_t>(state, dtree::gini_index);
+}
+
 BENCHMARK(BM_algo<dtree::algos::optimal_split>)
     ->RangeMultiplier(10)
     ->Range(100, 10'000'000);
 
+template <typename cost_fn_t>
+void BM_optimal_split(benchmark::State& state, cost_fn_t cost_fn)
+{
+    BM_algo_cost_fn<dtree::algos::optimal_split>(state, cost_fn);
+}
+
+BENCHMARK_CAPTURE(BM_optimal_split, incremental_gini, dtree::gini_impurity {})
+    ->RangeMultiplier(10)
+    ->Range(100, 10'000'000);
+
+BENCHMARK_CAPTURE(BM_optimal_split, incremental_entropy, dtree::entropy_impurity {})
+    ->RangeMultiplier(10)
+    ->Range(100, 10'000'000);
+
+template <typename cost_fn_t>
+void BM_binary_optimal_split(benchmark::State& state, cost_fn_t cost_fn)
+{
+    BM_algo_cost_fn<dtree::algos::basic_optimal_split<2>>(state, cost_fn);
+}
+
+BENCHMARK_CAPTURE(BM_binary_optimal_split, gini, dtree::gini_impurity {})
+    ->RangeMultiplier(10)
+    ->Range(100, 10'000'000);
+
+BENCHMARK_CAPTURE(BM_binary_optimal_split, entropy, dtree::entropy_impurity {})
+    ->RangeMultiplier(10)
+    ->Range(100, 10'000'000);
+
 BENCHMARK(BM_algo<dtree::algos::median_split>)
     ->RangeMultiplier(10)
     ->Range(100, 10'000'000);
 
+void BM_sampled_median_split(
+    benchmark::State& state, dtree::algos::median_split algo)
+{
+    BM_algo_with(state, algo, dtree::gini_index);
+}
+
+BENCHMARK_CAPTURE(BM_sampled_median_split, 10000, dtree::algos::median_split { 10'000u })
+    ->RangeMultiplier(10)
+    ->Range(100, 10'000'000);
+
+void BM_calculate_cost(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    std::vector<double> feature;
+    labels labels;
+
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        feature.push_back(f_dist(gen));
+        labels.push_back(l_dist(gen));
+    }
+
+    single_numeric_splitting splitting { 0.0 };
+
+    for (auto _ : state) {
+        auto out = algos::calculate_cost(splitting, feature, labels, gini_index);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(
+        state.iterations() * n_samples * (sizeof(double) + sizeof(labels::label_t)));
+}
+
+BENCHMARK(BM_calculate_cost)->RangeMultiplier(10)->Range(100, 10'000'000);
+
+void BM_histogram_split(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    std::vector<double> feature;
+    labels labels;
+
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        feature.push_back(f_dist(gen));
+        labels.push_back(l_dist(gen));
+    }
+
+    auto binned = make_binned_feature(feature);
+    algos::histogram_split algo;
+
+    for (auto _ : state) {
+        auto out = algo(binned, labels, gini_index);
+        benchmark::DoNotOptimize(out);
+    }
+}
+
+BENCHMARK(BM_histogram_split)->RangeMultiplier(10)->Range(100, 10'000'000);
+
+void BM_random_hyperplane_split(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+    std::size_t n_projections = state.range(1);
+
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    // 64 dimensional embeddings
+    std::vector<std::vector<double>> feature;
+    labels labels;
+
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        std::vector<double> sample(64);
+        for (auto& x : sample)
+            x = f_dist(gen);
+        feature.push_back(std::move(sample));
+        labels.push_back(l_dist(gen));
+    }
+
+    algos::random_hyperplane_split<algos::optimal_split> algo {
+        algos::random_hyperplane_config { 1u, n_projections }
+    };
+
+    for (auto _ : state) {
+        auto out = algo(feature, labels, gini_impurity {});
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples * n_projections);
+}
+
+BENCHMARK(BM_random_hyperplane_split)
+    ->ArgsProduct({ { 1'000, 10'000, 100'000 }, { 1, 8 } });
+
+void BM_category_split(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+    auto n_categories = static_cast<std::uint32_t>(state.range(1));
+    std::size_t n_labels = state.range(2);
+
+    std::mt19937 gen {};
+    std::uniform_int_distribution<std::uint32_t> c_dist { 0, n_categories - 1 };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, n_labels - 1 };
+
+    std::vector<category> feature;
+    labels labels;
+
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        feature.push_back({ c_dist(gen) });
+        labels.push_back(l_dist(gen));
+    }
+
+    algos::category_split algo;
+
+    for (auto _ : state) {
+        auto out = algo(feature, labels, gini_impurity {});
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_category_split)
+    ->ArgsProduct({ { 10'000, 1'000'000 }, { 10, 1'000 }, { 2, 5 } });
+
 BENCHMARK_MAIN();
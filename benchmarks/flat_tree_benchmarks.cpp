@@ -0,0 +1,204 @@
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dtree/algos/single_numeric.h"
+#include "dtree/compact_tree.h"
+#include "dtree/complete_tree.h"
+#include "dtree/dataset.h"
+#include "dtree/flat_tree.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/labels.h"
+#include "dtree/packed_tree.h"
+#include "dtree/tree_builder.h"
+
+namespace {
+
+constexpr std::size_t n_features = 8;
+
+dtree::dataset make_batch(std::size_t n_samples, unsigned int seed)
+{
+    std::mt19937 gen { seed };
+    std::normal_distribution<double> f_dist;
+
+    dtree::dataset batch { n_features, n_samples };
+    for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id) {
+        for (double& x : batch.column(feature_id))
+            x = f_dist(gen);
+    }
+    return batch;
+}
+
+// a tree grown to the given depth on labels that depend on every feature
+auto make_tree(std::size_t depth)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = 50'000;
+    auto train = make_batch(n_samples, 1u);
+
+    std::unordered_map<std::size_t, std::vector<double>> features;
+    for (const auto& [feature_id, feature] : train)
+        features.emplace(feature_id, std::vector<double>(begin(feature), end(feature)));
+
+    labels labels;
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        double x = 0.0;
+        for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id)
+            x += train.column(feature_id)[i] * (feature_id % 2 ? 1.0 : -1.0);
+        labels.push_back(static_cast<std::size_t>(std::abs(x) * 4) % 3);
+    }
+
+    tree_builder builder { tree_builder_config { false, 0u, depth, 1u, 1.0 },
+        algos::optimal_split {}, gini_index };
+    return builder.build(features, labels);
+}
+
+} // namespace
+
+void BM_apply(benchmark::State& state)
+{
+    std::size_t n_samples = state.range(0);
+    auto tree = make_tree(state.range(1));
+    auto batch = make_batch(n_samples, 2u);
+
+    std::vector<double> sample(n_features);
+    std::vector<double> out(3 * n_samples);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n_samples; ++i) {
+            for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id)
+                sample[feature_id] = batch.column(feature_id)[i];
+            const auto& distribution = tree.apply(sample);
+            std::copy(begin(distribution), end(distribution), begin(out) + 3 * i);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_apply)->ArgsProduct({ { 1'000, 100'000 }, { 8, 16 } });
+
+void BM_apply_batch(benchmark::State& state)
+{
+    std::size_t n_samples = state.range(0);
+    auto tree = make_tree(state.range(1));
+    auto batch = make_batch(n_samples, 2u);
+
+    std::vector<double> out(3 * n_samples);
+    for (auto _ : state) {
+        tree.apply_batch(batch, std::span { out });
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_apply_batch)->ArgsProduct({ { 1'000, 100'000 }, { 8, 16 } });
+
+void BM_complete_apply_batch(benchmark::State& state)
+{
+    std::size_t n_samples = state.range(0);
+    dtree::complete_tree tree { make_tree(state.range(1)) };
+    auto batch = make_batch(n_samples, 2u);
+
+    std::vector<double> out(tree.width() * n_samples);
+    for (auto _ : state) {
+        tree.apply_batch(batch, std::span { out });
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_complete_apply_batch)->ArgsProduct({ { 1'000, 100'000 }, { 8, 16 } });
+
+// a tree far larger than the caches, which a trained one of this file is not: every
+// node above the given depth splits on a random feature at a random threshold with
+// probability 0.92, giving around eight million nodes (125MB) at depth 24
+auto make_large_tree(std::size_t depth)
+{
+    using tree_t = dtree::compact_tree<dtree::node<dtree::single_numeric_splitting>>;
+
+    std::mt19937 gen { 3u };
+    std::normal_distribution<double> t_dist;
+    std::uniform_int_distribution<std::uint32_t> f_dist { 0, n_features - 1 };
+    std::bernoulli_distribution split_dist { 0.92 };
+
+    std::vector<tree_t::node_type> nodes(1);
+    std::vector<std::size_t> depths { 0u };
+    std::uint32_t n_leaves = 0;
+    for (std::size_t loc = 0; loc < nodes.size(); ++loc) {
+        if (depths[loc] < depth && (depths[loc] < 4 || split_dist(gen))) {
+            auto child = static_cast<std::uint32_t>(nodes.size());
+            nodes[loc] = { { t_dist(gen) }, f_dist(gen), child };
+            nodes.resize(nodes.size() + 2);
+            depths.resize(depths.size() + 2, depths[loc] + 1);
+        } else {
+            nodes[loc] = { {}, tree_t::node_type::no_feature, n_leaves++ };
+        }
+    }
+    return tree_t { std::move(nodes), {}, std::vector<double>(3 * n_leaves, 1.0 / 3),
+        3u };
+}
+
+// the second argument picks the layout of the nodes, breadth first (0) or van Emde
+// Boas (1)
+void BM_compact_apply(benchmark::State& state)
+{
+    std::size_t n_samples = 100'000;
+    auto tree = make_large_tree(state.range(0));
+    if (state.range(1) == 1)
+        tree = dtree::van_emde_boas_layout(tree);
+    auto batch = make_batch(n_samples, 2u);
+
+    std::vector<double> sample(n_features);
+    std::vector<double> out(tree.width() * n_samples);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n_samples; ++i) {
+            for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id)
+                sample[feature_id] = batch.column(feature_id)[i];
+            auto distribution = tree.apply(sample);
+            std::copy(begin(distribution), end(distribution),
+                begin(out) + tree.width() * i);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+    state.counters["nodes"] = tree.size();
+}
+
+BENCHMARK(BM_compact_apply)->ArgsProduct({ { 12, 24 }, { 0, 1 } });
+
+// samples binned ahead of the loop, as the trees of a model sharing their cuts bin a
+// sample once for all of them
+void BM_packed_apply_binned(benchmark::State& state)
+{
+    std::size_t n_samples = state.range(0);
+    dtree::packed_tree tree { make_tree(state.range(1)) };
+    auto batch = make_batch(n_samples, 2u);
+
+    using code_type = dtree::packed_tree<>::code_type;
+    std::vector<code_type> codes(n_samples * n_features);
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id) {
+            codes[i * n_features + feature_id]
+                = tree.cuts().bin(feature_id, batch.column(feature_id)[i]);
+        }
+    }
+
+    std::vector<float> out(3 * n_samples);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n_samples; ++i) {
+            auto distribution
+                = tree.apply_binned({ codes.data() + i * n_features, n_features });
+            std::copy(begin(distribution), end(distribution), begin(out) + 3 * i);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_packed_apply_binned)->ArgsProduct({ { 1'000, 100'000 }, { 8, 16 } });
+
+BENCHMARK_MAIN();
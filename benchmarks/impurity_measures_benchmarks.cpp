@@ -1,4 +1,3 @@
-
 #include <benchmark/benchmark.h>
 
 #include "dtree/impurity_measures.h"
@@ -17,4 +16,31 @@ void BM_gini_index(benchmark::State& state)
 
 BENCHMARK(BM_gini_index);
 
+// the counts of a node in a multi class tree, below max_count: deep in the tree they
+// are mostly small and some empty, near the root most are past the c log2(c) table
+std::vector<std::size_t> make_counts(std::size_t n_classes, std::size_t max_count)
+{
+    std::vector<std::size_t> counts(n_classes);
+    for (std::size_t i = 0; i < n_classes; ++i)
+        counts[i] = (i * 7919u) % max_count;
+    return counts;
+}
+
+void BM_multi_class(
+    benchmark::State& state, double (*measure)(const dtree::label_counts&))
+{
+    auto counts = make_counts(state.range(0), state.range(1));
+
+    for (auto _ : state) {
+        auto out = measure(counts);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_multi_class, gini_index, dtree::gini_index)
+    ->ArgsProduct({ { 2, 10, 100, 1000 }, { 1500, 100'000 } });
+BENCHMARK_CAPTURE(BM_multi_class, entropy, dtree::entropy)
+    ->ArgsProduct({ { 2, 10, 100, 1000 }, { 1500, 100'000 } });
+
 BENCHMARK_MAIN();
@@ -0,0 +1,90 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "dtree/algos/strings.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/labels.h"
+
+// log lines of a few tokens from a small vocabulary
+std::pair<std::vector<std::string>, dtree::labels> make_log_lines(
+    std::size_t n_samples, std::vector<std::string>& vocabulary, std::mt19937& gen)
+{
+    std::uniform_int_distribution<int> c_dist { 'a', 'z' };
+    std::uniform_int_distribution<std::size_t> length_dist { 3, 8 };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    for (std::size_t i = 0; i < 1000; ++i) {
+        std::string token;
+        for (std::size_t j = length_dist(gen); j > 0; --j)
+            token.push_back(static_cast<char>(c_dist(gen)));
+        vocabulary.push_back(std::move(token));
+    }
+    std::uniform_int_distribution<std::size_t> v_dist { 0, vocabulary.size() - 1 };
+
+    std::vector<std::string> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        std::string line;
+        for (std::size_t token = 0; token < 12; ++token)
+            line += vocabulary[v_dist(gen)] + ' ';
+        feature.push_back(std::move(line));
+        labels.push_back(l_dist(gen));
+    }
+    return { std::move(feature), std::move(labels) };
+}
+
+// a corpus of token fragments
+void BM_substring_split(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+    std::size_t corpus_size = state.range(1);
+
+    std::mt19937 gen {};
+    std::vector<std::string> vocabulary;
+    auto [feature, labels] = make_log_lines(n_samples, vocabulary, gen);
+    std::uniform_int_distribution<std::size_t> v_dist { 0, vocabulary.size() - 1 };
+
+    std::vector<std::string> corpus;
+    for (std::size_t i = 0; i < corpus_size; ++i) {
+        const auto& token = vocabulary[v_dist(gen)];
+        corpus.push_back(token.substr(i % 2, token.size() - i % 3));
+    }
+
+    algos::substring_split algo { corpus };
+
+    for (auto _ : state) {
+        auto out = algo(feature, labels, gini_impurity {});
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_substring_split)->ArgsProduct({ { 1'000, 100'000 }, { 100, 100'000 } });
+
+void BM_mined_substring_split(benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_samples = state.range(0);
+
+    std::mt19937 gen {};
+    std::vector<std::string> vocabulary;
+    auto [feature, labels] = make_log_lines(n_samples, vocabulary, gen);
+
+    algos::mined_substring_split algo { { n_samples / 100 + 1, 16u } };
+
+    for (auto _ : state) {
+        auto out = algo(feature, labels, gini_impurity {});
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetItemsProcessed(state.iterations() * n_samples);
+}
+
+BENCHMARK(BM_mined_substring_split)->RangeMultiplier(10)->Range(100, 10'000);
+
+BENCHMARK_MAIN();
@@ -7,19 +7,19 @@
 #include <benchmark/benchmark.h>
 
 #include "dtree/algos/single_numeric.h"
+#include "dtree/binning.h"
+#include "dtree/dataset.h"
+#include "dtree/executor.h"
 #include "dtree/impurity_measures.h"
 #include "dtree/labels.h"
+#include "dtree/level_wise_tree_builder.h"
 #include "dtree/tree_builder.h"
 
-void run_test(dtree::tree_builder_config config, benchmark::State& state)
-{
-    using namespace dtree;
-
-    std::size_t n_features = state.range(0);
-    std::size_t n_samples = state.range(1);
-
-    std::size_t max_depth = 10;
+namespace {
 
+std::unordered_map<std::size_t, std::vector<double>> make_features(
+    std::size_t n_features, std::size_t n_samples)
+{
     // std::random_device rd{};
     std::mt19937 gen {}; // gen{rd()}
 
@@ -37,7 +37,14 @@ void run_test(dtree::tree_builder_config config, benchmark::State& state)
         X.emplace(feature_id, std::move(feature));
     }
 
-    labels y;
+    return X;
+}
+
+dtree::labels make_labels(std::size_t n_samples)
+{
+    std::mt19937 gen { 1u };
+
+    dtree::labels y;
 
     std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
 
@@ -45,6 +52,39 @@ void run_test(dtree::tree_builder_config config, benchmark::State& state)
         y.push_back(l_dist(gen));
     }
 
+    return y;
+}
+
+} // namespace
+
+void run_test(dtree::tree_builder_config config, benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_features = state.range(0);
+    std::size_t n_samples = state.range(1);
+
+    auto X = make_features(n_features, n_samples);
+    auto y = make_labels(n_samples);
+
+    tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+    for (auto _ : state) {
+        auto out = builder.build(X, y);
+    }
+}
+
+template <typename dataset_t>
+void run_dataset_test(dtree::tree_builder_config config, benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_features = state.range(0);
+    std::size_t n_samples = state.range(1);
+
+    dataset_t X { make_features(n_features, n_samples) };
+    auto y = make_labels(n_samples);
+
     tree_builder builder { config, algos::optimal_split {}, gini_index };
 
     for (auto _ : state) {
@@ -52,6 +92,25 @@ void run_test(dtree::tree_builder_config config, benchmark::State& state)
     }
 }
 
+template <typename builder_t>
+void run_binned_test(const builder_t& builder, benchmark::State& state)
+{
+    using namespace dtree;
+
+    std::size_t n_features = state.range(0);
+    std::size_t n_samples = state.range(1);
+
+    std::unordered_map<std::size_t, binned_feature> X;
+    for (const auto& [feature_id, feature] : make_features(n_features, n_samples)) {
+        X.emplace(feature_id, make_binned_feature(feature));
+    }
+    auto y = make_labels(n_samples);
+
+    for (auto _ : state) {
+        auto out = builder.build(X, y);
+    }
+}
+
 void BM_build_tree_sync(benchmark::State& state)
 {
     run_test(dtree::tree_builder_config { false, 0u, 10u, 10u, 0.95 }, state);
@@ -59,7 +118,11 @@ void BM_build_tree_sync(benchmark::State& state)
 
 void BM_build_tree_async(benchmark::State& state)
 {
-    run_test(dtree::tree_builder_config { true, 0u, 10u, 10u, 0.95 }, state);
+    static dtree::work_stealing_pool pool {};
+
+    dtree::tree_builder_config config { true, 0u, 10u, 10u, 0.95 };
+    config.executor_ = &pool;
+    run_test(config, state);
 }
 
 void BM_build_tree_bounded_async(benchmark::State& state)
@@ -67,6 +130,60 @@ void BM_build_tree_bounded_async(benchmark::State& state)
     run_test(dtree::tree_builder_config { true, 20'000u, 10u, 10u, 0.95 }, state);
 }
 
+void BM_build_tree_presorted(benchmark::State& state)
+{
+    run_test(dtree::tree_builder_config { false, 0u, 10u, 10u, 0.95, true }, state);
+}
+
+void BM_build_tree_in_place(benchmark::State& state)
+{
+    dtree::tree_builder_config config { false, 0u, 10u, 10u, 0.95 };
+    config.in_place = true;
+    run_test(config, state);
+}
+
+void BM_build_tree_parallel_features(benchmark::State& state)
+{
+    static dtree::work_stealing_pool pool {};
+
+    dtree::tree_builder_config config { true, 20'000u, 10u, 10u, 0.95 };
+    config.in_place = true;
+    config.parallel_features = true;
+    config.parallel_features_sample_min = 20'000u;
+    config.executor_ = &pool;
+    run_test(config, state);
+}
+
+void BM_build_tree_dataset(benchmark::State& state)
+{
+    run_dataset_test<dtree::dataset>(
+        dtree::tree_builder_config { false, 0u, 10u, 10u, 0.95 }, state);
+}
+
+void BM_build_tree_float_dataset(benchmark::State& state)
+{
+    run_dataset_test<dtree::float_dataset>(
+        dtree::tree_builder_config { false, 0u, 10u, 10u, 0.95 }, state);
+}
+
+void BM_build_tree_histogram(benchmark::State& state)
+{
+    using namespace dtree;
+
+    tree_builder builder { tree_builder_config { false, 0u, 10u, 10u, 0.95 },
+        algos::histogram_split {}, gini_index };
+    run_binned_test(builder, state);
+}
+
+void BM_build_tree_level_wise(benchmark::State& state)
+{
+    using namespace dtree;
+
+    level_wise_tree_builder builder { tree_builder_config { false, 0u, 10u, 10u, 0.95 },
+        algos::histogram_split {}, gini_index };
+    run_binned_test(builder, state);
+}
+
 BENCHMARK(BM_build_tree_sync)
     ->Args({ 1, 1'000 })
     ->Args({ 1, 10'000 })
@@ -81,7 +198,35 @@ BENCHMARK(BM_build_tree_sync)
     ->Args({ 100, 100'000 })
     //->Args({100, 1'000'000})
     ;
-/*
+
+BENCHMARK(BM_build_tree_presorted)
+    ->Args({ 1, 1'000 })
+    ->Args({ 1, 10'000 })
+    ->Args({ 1, 100'000 })
+    ->Args({ 1, 1'000'000 })
+    ->Args({ 10, 1'000 })
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 100'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 1'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 100'000 })
+    ->Args({ 100, 1'000'000 });
+
+BENCHMARK(BM_build_tree_in_place)
+    ->Args({ 1, 1'000 })
+    ->Args({ 1, 10'000 })
+    ->Args({ 1, 100'000 })
+    ->Args({ 1, 1'000'000 })
+    ->Args({ 10, 1'000 })
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 100'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 1'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 100'000 })
+    ->Args({ 100, 1'000'000 });
+
 BENCHMARK(BM_build_tree_async)
     ->Args({ 1, 1'000 })
     ->Args({ 1, 10'000 })
@@ -94,8 +239,7 @@ BENCHMARK(BM_build_tree_async)
     ->Args({ 100, 1'000 })
     ->Args({ 100, 10'000 })
     ->Args({ 100, 100'000 })
-    //->Args({100, 1'000'000})
-    ;
+    ->Args({ 100, 1'000'000 });
 
 BENCHMARK(BM_build_tree_bounded_async)
     ->Args({ 1, 1'000 })
@@ -110,6 +254,46 @@ BENCHMARK(BM_build_tree_bounded_async)
     ->Args({ 100, 10'000 })
     ->Args({ 100, 100'000 })
     //->Args({100, 1'000'000})
-    ;*/
+    ;
+
+BENCHMARK(BM_build_tree_parallel_features)
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 100'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 100'000 })
+    ->Args({ 100, 1'000'000 });
+
+BENCHMARK(BM_build_tree_dataset)
+    ->Args({ 1, 1'000 })
+    ->Args({ 1, 100'000 })
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 1'000'000 });
+
+BENCHMARK(BM_build_tree_float_dataset)
+    ->Args({ 1, 1'000 })
+    ->Args({ 1, 100'000 })
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 1'000'000 });
+
+BENCHMARK(BM_build_tree_histogram)
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 100'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 100'000 })
+    ->Args({ 100, 1'000'000 });
+
+BENCHMARK(BM_build_tree_level_wise)
+    ->Args({ 10, 10'000 })
+    ->Args({ 10, 100'000 })
+    ->Args({ 10, 1'000'000 })
+    ->Args({ 100, 10'000 })
+    ->Args({ 100, 100'000 })
+    ->Args({ 100, 1'000'000 });
 
 BENCHMARK_MAIN();
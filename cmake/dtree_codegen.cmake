@@ -0,0 +1,42 @@
+# dtree_add_scoring_library(<target> MODEL <file> [FUNCTION <name>]
+#                           [NAMESPACE <name>] [BINARY])
+#
+# Compiles a tree of single numeric splits, serialized to MODEL as a boost text
+# archive, to a header defining NAMESPACE::FUNCTION (by default <target>::score) with
+# dtree_export_cpp, and adds an interface library <target> through which it is
+# included as "<target>/<FUNCTION>.h". BINARY reads a tree of binary_leaf. The header
+# is regenerated whenever the model changes.
+function(dtree_add_scoring_library target)
+    cmake_parse_arguments(ARG "BINARY" "MODEL;FUNCTION;NAMESPACE" "" ${ARGN})
+    if (NOT ARG_MODEL)
+        message(FATAL_ERROR "dtree_add_scoring_library(${target}) needs a MODEL")
+    endif()
+    if (NOT ARG_FUNCTION)
+        set(ARG_FUNCTION score)
+    endif()
+    if (NOT ARG_NAMESPACE)
+        set(ARG_NAMESPACE ${target})
+    endif()
+
+    get_filename_component(model ${ARG_MODEL} ABSOLUTE)
+    set(include_dir ${CMAKE_CURRENT_BINARY_DIR}/${target}_generated)
+    set(header ${include_dir}/${target}/${ARG_FUNCTION}.h)
+
+    set(flags --namespace ${ARG_NAMESPACE} --function ${ARG_FUNCTION})
+    if (ARG_BINARY)
+        list(APPEND flags --binary)
+    endif()
+
+    add_custom_command(
+        OUTPUT ${header}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${include_dir}/${target}
+        COMMAND dtree_export_cpp ${model} ${header} ${flags}
+        DEPENDS dtree_export_cpp ${model}
+        COMMENT "Compiling ${ARG_MODEL} to ${ARG_NAMESPACE}::${ARG_FUNCTION}"
+    )
+    add_custom_target(${target}_codegen DEPENDS ${header})
+
+    add_library(${target} INTERFACE)
+    add_dependencies(${target} ${target}_codegen)
+    target_include_directories(${target} INTERFACE ${include_dir})
+endfunction()
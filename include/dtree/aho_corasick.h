@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dtree {
+
+/// aho_corasick
+///
+/// An automaton matching a set of patterns against a text in a single pass, however
+/// many patterns there are. The states are the prefixes of the patterns numbered in
+/// breadth first order, with the transitions of each stored as a sorted run of a
+/// shared edge array and a full table for the root, where most mismatches end up.
+/// Each state also links to the longest proper suffix that is a state (its failure
+/// link) and to the longest proper suffix that is a whole pattern (its output link).
+/// Duplicate patterns are kept once, so the ids are the positions of the distinct
+/// patterns in the order given.
+class aho_corasick {
+public:
+    static constexpr std::uint32_t no_pattern = UINT32_MAX;
+
+    explicit aho_corasick(const std::vector<std::string>& patterns);
+
+    template <std::ranges::input_range range_t>
+    explicit aho_corasick(const range_t& patterns)
+        : aho_corasick(std::vector<std::string>(
+            std::ranges::begin(patterns), std::ranges::end(patterns)))
+    {
+    }
+
+    /// The number of distinct patterns.
+    std::size_t size() const { return m_patterns.size(); }
+
+    std::size_t number_of_states() const { return m_fail.size(); }
+
+    const std::string& operator[](std::size_t id) const { return m_patterns[id]; }
+
+    /// Calls on_match(id) once for every pattern that occurs in the text, however often
+    /// it occurs. visited has an entry per state and is marked with the stamp for each
+    /// state reached. A state already marked has had its matches reported, along with
+    /// those of the states on its output links, so the scan stops following the links
+    /// there. Giving each text a new stamp saves clearing visited between texts.
+    template <typename on_match_t>
+    void for_each_pattern(std::string_view text, std::span<std::uint32_t> visited,
+        std::uint32_t stamp, on_match_t&& on_match) const
+    {
+        if (m_pattern[0] != no_pattern)
+            on_match(m_pattern[0]);
+
+        std::uint32_t state = 0;
+        for (unsigned char c : text) {
+            state = next(state, c);
+            for (std::uint32_t s = state; s != 0 && visited[s] != stamp;
+                 s = m_output_link[s]) {
+                visited[s] = stamp;
+                if (m_pattern[s] != no_pattern)
+                    on_match(m_pattern[s]);
+            }
+        }
+    }
+
+    /// The state reached from the state on reading c.
+    std::uint32_t next(std::uint32_t state, unsigned char c) const
+    {
+        while (state != 0) {
+            for (std::uint32_t e = m_edges_begin[state]; e < m_edges_begin[state + 1];
+                 ++e) {
+                if (m_edge_chars[e] == c)
+                    return m_edge_targets[e];
+            }
+            state = m_fail[state];
+        }
+        return m_root[c];
+    }
+
+private:
+    std::vector<std::string> m_patterns;
+
+    std::array<std::uint32_t, 256> m_root;
+
+    std::vector<std::uint32_t> m_edges_begin;
+
+    std::vector<unsigned char> m_edge_chars;
+
+    std::vector<std::uint32_t> m_edge_targets;
+
+    std::vector<std::uint32_t> m_fail;
+
+    std::vector<std::uint32_t> m_output_link;
+
+    std::vector<std::uint32_t> m_pattern;
+};
+
+} // namespace dtree
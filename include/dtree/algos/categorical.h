@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <memory_resource>
+#include <vector>
+
+#include "dtree/algos/cost_utils.h"
+#include "dtree/arena.h"
+#include "dtree/categorical.h"
+#include "dtree/concepts.h"
+#include "dtree/labels.h"
+#include "dtree/splittings.h"
+
+namespace dtree::algos {
+
+/// category_split
+///
+/// Finds the subset of the categories of a categorical feature to split off with the
+/// lowest cost. After counting the labels of each category present, the categories
+/// are ordered by the share of their samples with a given label and the prefixes of
+/// that order are scanned as the thresholds of a sorted feature would be. With two
+/// labels the best subset is always such a prefix for the order by either label
+/// (Breiman et al.), so one scan finds the optimum over all 2^(k - 1) subsets. With
+/// more labels the order by each label is scanned in turn, a one vs rest heuristic
+/// that is O(labels * k log k) rather than exponential in k. Unknown categories
+/// always stay above the split.
+class category_split {
+public:
+    using splitting_type = category_splitting;
+
+    template <categorical_feature_c feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> operator()(
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
+    {
+        const label_counts& counts = labels.get_label_counts();
+        std::size_t n_labels = counts.size();
+
+        scratch_scope scope;
+        std::pmr::vector<std::uint32_t> present { scope.resource() };
+        std::pmr::vector<std::size_t> hits { scope.resource() };
+        count_categories(feature, labels, n_labels, present, hits);
+        std::size_t n_present = present.size();
+
+        double best_cost = cost_fn(counts);
+        std::size_t best_label = 0u;
+        std::size_t best_size = 0u;
+
+        // with two labels the orders by each are the reverse of each other
+        std::size_t n_orders = n_labels == 2 ? 1u : n_labels;
+        std::pmr::vector<std::uint32_t> order(n_present, scope.resource());
+        for (std::size_t label = 0; label < n_orders && n_present > 1; ++label) {
+            sort_by_share(order, hits, n_labels, label);
+
+            split_scan<std::remove_cvref_t<cost_fn_t>> scan { cost_fn, counts };
+            for (std::size_t size = 1; size < n_present; ++size) {
+                std::size_t k = order[size - 1];
+                for (std::size_t l = 0; l < n_labels; ++l) {
+                    if (std::size_t count = hits[k * n_labels + l])
+                        scan.move_below(l, count);
+                }
+
+                double cost = scan.cost();
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_label = label;
+                    best_size = size;
+                }
+            }
+        }
+
+        splitting_type splitting;
+        if (best_size > 0) {
+            sort_by_share(order, hits, n_labels, best_label);
+            for (std::size_t i = 0; i < best_size; ++i) {
+                std::uint32_t code = present[order[i]];
+                if (code / 64 >= splitting.categories.size())
+                    splitting.categories.resize(code / 64 + 1, 0u);
+                splitting.categories[code / 64] |= std::uint64_t { 1 } << (code % 64);
+            }
+        }
+        return { best_cost, std::move(splitting) };
+    }
+
+private:
+    /// The codes of the categories present, in increasing order, and the label counts
+    /// of each as hits[k * n_labels + label]. A table over the codes finds the
+    /// categories when the codes are few enough for the samples, otherwise they are
+    /// found by sorting.
+    template <typename feature_t, typename labels_t>
+    static void count_categories(const feature_t& feature, const labels_t& labels,
+        std::size_t n_labels, std::pmr::vector<std::uint32_t>& present,
+        std::pmr::vector<std::size_t>& hits)
+    {
+        std::size_t n = labels.size();
+
+        std::uint32_t max_code = 0u;
+        bool any_known = false;
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t code = feature[i].code;
+            if (code != category_dictionary::unknown) {
+                max_code = std::max(max_code, code);
+                any_known = true;
+            }
+        }
+        if (!any_known)
+            return;
+
+        constexpr std::uint32_t absent = UINT32_MAX;
+        std::pmr::vector<std::uint32_t> slots { present.get_allocator() };
+        if (max_code < 4 * n + 256) {
+            slots.assign(std::size_t { max_code } + 1, absent);
+            for (std::size_t i = 0; i < n; ++i) {
+                std::uint32_t code = feature[i].code;
+                if (code != category_dictionary::unknown)
+                    slots[code] = 0u;
+            }
+            for (std::uint32_t code = 0; code <= max_code; ++code) {
+                if (slots[code] != absent) {
+                    slots[code] = static_cast<std::uint32_t>(present.size());
+                    present.push_back(code);
+                }
+            }
+        } else {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::uint32_t code = feature[i].code;
+                if (code != category_dictionary::unknown)
+                    present.push_back(code);
+            }
+            std::sort(begin(present), end(present));
+            present.erase(std::unique(begin(present), end(present)), end(present));
+        }
+
+        hits.assign(present.size() * n_labels, 0u);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t code = feature[i].code;
+            if (code == category_dictionary::unknown)
+                continue;
+
+            std::size_t k = slots.empty()
+                ? std::lower_bound(begin(present), end(present), code) - begin(present)
+                : slots[code];
+            hits[k * n_labels + labels[i]]++;
+        }
+    }
+
+    /// Orders the categories present by the share of their samples with the label,
+    /// ties by code.
+    static void sort_by_share(std::pmr::vector<std::uint32_t>& order,
+        const std::pmr::vector<std::size_t>& hits, std::size_t n_labels,
+        std::size_t label)
+    {
+        std::pmr::vector<std::size_t> totals(order.size(), 0u, order.get_allocator());
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            order[k] = static_cast<std::uint32_t>(k);
+            for (std::size_t l = 0; l < n_labels; ++l)
+                totals[k] += hits[k * n_labels + l];
+        }
+
+        // a / b < c / d as a * d < c * b, the totals being positive
+        std::stable_sort(begin(order), end(order),
+            [&hits, &totals, n_labels, label](std::uint32_t lhs, std::uint32_t rhs) {
+                return hits[lhs * n_labels + label] * totals[rhs]
+                    < hits[rhs * n_labels + label] * totals[lhs];
+            });
+    }
+};
+
+} // dtree::algos
@@ -1,14 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
 #include "dtree/concepts.h"
 #include "dtree/labels.h"
 #include "dtree/splittings.h"
 
 namespace dtree::algos {
 
-template <typename splitting_t, typename feature_t, cost_fn_c cost_fn_t>
+template <typename splitting_t, typename feature_t, labels_c labels_t,
+    cost_fn_c cost_fn_t>
 double calculate_cost(const splitting_t& splitting, const feature_t& feature,
-    const labels& labels, cost_fn_t&& cost_fn)
+    const labels_t& labels, cost_fn_t&& cost_fn)
 {
     label_counts counts_above = labels.get_label_counts();
     label_counts counts_below(counts_above.size(), 0u);
@@ -35,4 +44,187 @@ double calculate_cost(const splitting_t& splitting, const feature_t& feature,
     return cost;
 }
 
+/// As calculate_cost, for a single numeric split of contiguous samples. The samples
+/// are taken in blocks and the split is first evaluated over a block into a mask of
+/// 0s and 1s, which is then added into the counts below the split. With few labels
+/// and contiguous labels (as with basic_labels rather than labels_view) this is a
+/// compare and add per label, otherwise the counts are indexed by the labels. Neither
+/// loop branches on the samples so both vectorise.
+template <std::ranges::contiguous_range feature_t, labels_c labels_t,
+    cost_fn_c cost_fn_t>
+requires single_numeric_feature_c<feature_t>
+double calculate_cost(const single_numeric_splitting& splitting,
+    const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn)
+{
+    constexpr std::size_t block_size = 256;
+    // above this the passes over the block cost more than indexing the counts
+    constexpr std::size_t max_compared_labels = 8;
+
+    const auto* samples = std::ranges::data(feature);
+    std::size_t n = std::ranges::size(feature);
+
+    label_counts counts_above = labels.get_label_counts();
+    label_counts counts_below(counts_above.size(), 0u);
+    std::size_t n_labels = counts_above.size();
+
+    std::size_t total_below = 0u;
+    std::array<std::uint32_t, block_size> below;
+
+    for (std::size_t first = 0; first < n; first += block_size) {
+        std::size_t size = std::min(block_size, n - first);
+
+        std::uint32_t block_below = 0u;
+        for (std::size_t i = 0; i < size; ++i) {
+            below[i] = splitting(samples[first + i]);
+            block_below += below[i];
+        }
+        total_below += block_below;
+
+        if constexpr (std::ranges::contiguous_range<labels_t>) {
+            if (n_labels <= max_compared_labels) {
+                const auto* block_labels = std::ranges::data(labels) + first;
+                for (std::size_t label = 0; label < n_labels; ++label) {
+                    std::uint32_t count = 0u;
+                    for (std::size_t i = 0; i < size; ++i)
+                        count += below[i] & (block_labels[i] == label);
+                    counts_below[label] += count;
+                }
+                continue;
+            }
+        }
+
+        for (std::size_t i = 0; i < size; ++i)
+            counts_below[labels[first + i]] += below[i];
+    }
+
+    for (std::size_t label = 0; label < n_labels; ++label)
+        counts_above[label] -= counts_below[label];
+
+    double total_count = n;
+    double cost = ((n - total_below) / total_count) * cost_fn(counts_above)
+        + (total_below / total_count) * cost_fn(counts_below);
+
+    return cost;
+}
+
+template <std::size_t n_classes>
+using fixed_label_counts = std::array<std::size_t, n_classes>;
+
+/// The counts as a fixed_label_counts, throwing if there is a label of n_classes or
+/// more.
+template <std::size_t n_classes>
+fixed_label_counts<n_classes> to_fixed_counts(const label_counts& counts)
+{
+    if (counts.size() > n_classes) {
+        std::stringstream msg;
+        msg << "Expected at most " << n_classes << " labels but got " << counts.size();
+
+        throw std::runtime_error { msg.str() };
+    }
+
+    fixed_label_counts<n_classes> out {};
+    std::copy(begin(counts), end(counts), begin(out));
+    return out;
+}
+
+/// The cost of fixed counts, by the cost function's overload for them if it has one
+/// (see fixed_cost_fn_c) and otherwise by copying them into label_counts.
+template <typename cost_fn_t, std::size_t n_classes>
+double fixed_cost(const cost_fn_t& cost_fn, const fixed_label_counts<n_classes>& counts)
+{
+    if constexpr (fixed_cost_fn_c<const cost_fn_t&, n_classes>) {
+        return cost_fn(counts);
+    } else {
+        return cost_fn(label_counts(begin(counts), end(counts)));
+    }
+}
+
+/// split_scan
+///
+/// The label counts either side of a split as the samples of a node move from above
+/// it to below it, as when scanning the candidate thresholds of a sorted feature.
+/// Every sample starts above the split. With an incremental_cost_fn_c the costs of the
+/// two sides are updated as samples move, otherwise the cost function is called on
+/// the counts of both sides whenever the cost is asked for.
+template <typename cost_fn_t> class split_scan {
+public:
+    split_scan(const cost_fn_t& cost_fn, label_counts counts_above)
+        : m_cost_fn { cost_fn }
+        , m_counts_below(counts_above.size(), 0u)
+        , m_counts_above { std::move(counts_above) }
+        , m_total_below { 0u }
+        , m_total { 0u }
+    {
+        for (std::size_t c : m_counts_above)
+            m_total += c;
+    }
+
+    /// Moves count samples of the label from above the split to below it.
+    void move_below(std::size_t label, std::size_t count = 1)
+    {
+        m_counts_below[label] += count;
+        m_counts_above[label] -= count;
+        m_total_below += count;
+    }
+
+    /// The cost of the split, the cost of each side weighted by its share of the
+    /// samples.
+    double cost() const
+    {
+        double total_count = m_total;
+        return (m_total_below / total_count) * m_cost_fn(m_counts_below)
+            + ((m_total - m_total_below) / total_count) * m_cost_fn(m_counts_above);
+    }
+
+private:
+    const cost_fn_t& m_cost_fn;
+
+    label_counts m_counts_below;
+
+    label_counts m_counts_above;
+
+    std::size_t m_total_below;
+
+    std::size_t m_total;
+};
+
+template <incremental_cost_fn_c cost_fn_t> class split_scan<cost_fn_t> {
+public:
+    split_scan(const cost_fn_t& cost_fn, label_counts counts_above)
+        : m_below { cost_fn.accumulate(label_counts(counts_above.size(), 0u)) }
+        , m_above { cost_fn.accumulate(counts_above) }
+        , m_total_below { 0u }
+        , m_total { 0u }
+    {
+        for (std::size_t c : counts_above)
+            m_total += c;
+    }
+
+    void move_below(std::size_t label, std::size_t count = 1)
+    {
+        m_below.add(label, count);
+        m_above.remove(label, count);
+        m_total_below += count;
+    }
+
+    double cost() const
+    {
+        double total_count = m_total;
+        return (m_total_below / total_count) * m_below.cost()
+            + ((m_total - m_total_below) / total_count) * m_above.cost();
+    }
+
+private:
+    using accumulator_t
+        = decltype(std::declval<const cost_fn_t&>().accumulate(label_counts {}));
+
+    accumulator_t m_below;
+
+    accumulator_t m_above;
+
+    std::size_t m_total_below;
+
+    std::size_t m_total;
+};
+
 } // dtrees::algos
@@ -24,32 +24,43 @@ public:
     {
     }
 
-    template <mixed_feature_c mixed_feature_t, cost_fn_c cost_fn_t>
+    template <mixed_feature_c mixed_feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> operator()(const mixed_feature_t& mixed_feature,
-        const labels& labels_, cost_fn_t&& cost_fn) const
+        const labels_t& labels_, cost_fn_t&& cost_fn) const
     {
         return std::visit(
-            [this, &labels_, &cost_fn]<typename feature_t>(const feature_t& feature) {
-                static_assert(has_invocable<algo_ts...>::template value<feature_t,
-                                  labels, cost_fn_t>(),
-                    "At least one of the mixed algos must be able to split the feature");
-                double current_best = std::numeric_limits<double>::max();
-                splitting_type current_splitting;
-                return get_best_splitting<0>(
-                    current_best, current_splitting, feature, labels_, cost_fn);
+            [this, &labels_, &cost_fn](const auto& feature) {
+                return (*this)(feature, labels_, cost_fn);
             },
             mixed_feature);
     }
 
+    /// Splits a single alternative of a mixed feature, e.g. when the builder has
+    /// already visited the variant to take a view of its samples.
+    template <typename feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
+        requires(!mixed_feature_c<feature_t>)
+    std::pair<double, splitting_type> operator()(
+        const feature_t& feature, const labels_t& labels_, cost_fn_t&& cost_fn) const
+    {
+        static_assert(
+            has_invocable<algo_ts...>::template value<feature_t, labels_t, cost_fn_t>(),
+            "At least one of the mixed algos must be able to split the feature");
+        double current_best = std::numeric_limits<double>::max();
+        splitting_type current_splitting;
+        return get_best_splitting<0>(
+            current_best, current_splitting, feature, labels_, cost_fn);
+    }
+
 private:
-    template <std::size_t index, typename feature_t, cost_fn_c cost_fn_t>
+    template <std::size_t index, typename feature_t, labels_c labels_t,
+        cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> get_best_splitting(double current_best,
         const splitting_type& current_splitting, const feature_t& feature,
-        const labels& labels_, cost_fn_t&& cost_fn) const
+        const labels_t& labels_, cost_fn_t&& cost_fn) const
     {
         if constexpr (index < sizeof...(algo_ts)) {
             using algo_t = element_t<index, algo_ts...>;
-            if constexpr (std::is_invocable_v<algo_t, feature_t, labels, cost_fn_t>) {
+            if constexpr (std::is_invocable_v<algo_t, feature_t, labels_t, cost_fn_t>) {
                 const auto& algo = std::get<index>(m_algos);
                 auto [cost, splitting] = algo(feature, labels_, cost_fn);
                 return get_best_splitting<index + 1>(
@@ -1,9 +1,16 @@
 #pragma once
 
-#include <numeric>
-#include <ranges>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <random>
+#include <span>
+#include <vector>
 
 #include "dtree/algos/single_numeric.h"
+#include "dtree/arena.h"
 #include "dtree/concepts.h"
 #include "dtree/labels.h"
 
@@ -13,42 +20,144 @@ namespace dtree::algos {
 std::vector<double> generate_random_normal(
     std::size_t n_features, unsigned int seed = 0);
 
+/// n_projections random normals of dimension n_features drawn from the generator, as
+/// the rows of a row major matrix.
+std::vector<double> generate_random_normals(
+    std::size_t n_projections, std::size_t n_features, std::mt19937& gen);
+
+/// The generator of a node's normals. With a seed of 0 it is seeded at random,
+/// otherwise from the seed and the key, which identifies the node by its samples so
+/// that the normals don't depend on the thread the node is split on or the order the
+/// nodes are split in.
+std::mt19937 make_generator(unsigned int seed, std::size_t key);
+
+struct random_hyperplane_config {
+    /// 0 draws a random seed for every node
+    unsigned int seed = 0u;
+    /// the number of random normals tried at each node
+    std::size_t n_projections = 1u;
+};
+
+/// random_hyperplane_split
+///
+/// Splits a multi numeric feature by projecting it onto random normals and splitting
+/// the projections with the base algo, keeping the normal with the lowest cost. The
+/// projections onto all the normals are computed in one pass over the samples, a tile
+/// of them at a time (see project).
 template <typename base_algo_t> class random_hyperplane_split {
 public:
     using splitting_type = multi_numeric_splitting;
 
+    template <typename... arg_ts>
+    explicit random_hyperplane_split(random_hyperplane_config config, arg_ts&&... args)
+        : m_config { config }
+        , m_base_algo { std::forward<arg_ts>(args)... }
+    {
+    }
+
     template <typename... arg_ts>
     explicit random_hyperplane_split(unsigned int seed, arg_ts&&... args)
-        : m_seed { seed }
+        : m_config { seed }
         , m_base_algo { std::forward<arg_ts>(args)... }
     {
     }
 
     template <typename... arg_ts>
     explicit random_hyperplane_split(arg_ts&&... args)
-        : m_seed { 0u }
+        : m_config {}
         , m_base_algo { std::forward<arg_ts>(args)... }
     {
     }
 
-    template <multi_numeric_feature_c feature_t, typename cost_fn_t>
+    template <multi_numeric_feature_c feature_t, labels_c labels_t, typename cost_fn_t>
     std::pair<double, splitting_type> operator()(
-        const feature_t& feature, const labels& labels, cost_fn_t&& cost_fn) const
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
     {
+        std::size_t n = labels.size();
         std::size_t n_features = feature.front().size();
-        auto normal = generate_random_normal(n_features);
+        std::size_t n_projections = std::max<std::size_t>(m_config.n_projections, 1u);
+
+        auto gen = make_generator(m_config.seed, node_key(feature));
+        auto normals = generate_random_normals(n_projections, n_features, gen);
+
+        scratch_scope scope;
+        std::pmr::vector<double> projections(n_projections * n, scope.resource());
+        project(feature, normals, n_features, projections);
 
-        auto [cost, splitting]
-            = m_base_algo(feature | std::views::transform([&normal](auto&& x) {
-                  return std::inner_product(begin(x), end(x), begin(normal), 0.0);
-              }),
-                labels, cost_fn);
+        double best_cost = std::numeric_limits<double>::max();
+        std::size_t best_projection = 0u;
+        double best_split = 0.0;
+        for (std::size_t p = 0; p < n_projections; ++p) {
+            std::span<const double> projection { projections.data() + p * n, n };
+            auto [cost, splitting] = m_base_algo(projection, labels, cost_fn);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_projection = p;
+                best_split = splitting.split;
+            }
+        }
 
-        return { cost, multi_numeric_splitting { normal, splitting.split } };
+        auto normal = begin(normals) + best_projection * n_features;
+        return { best_cost,
+            multi_numeric_splitting { std::vector<double>(normal, normal + n_features),
+                best_split } };
     }
 
 private:
-    unsigned int m_seed;
+    // samples per tile, so that a tile of 64 dimensional samples fits in L1
+    static constexpr std::size_t tile_size = 32;
+
+    /// Identifies a node by its number of samples and the first and last of them.
+    template <typename feature_t> static std::size_t node_key(const feature_t& feature)
+    {
+        std::size_t key = std::ranges::size(feature);
+        auto mix = [&key](const auto& sample) {
+            for (std::size_t d = 0; d < sample.size(); ++d)
+                key = key * 0x100000001b3u ^ std::hash<double> {}(sample[d]);
+        };
+        mix(feature.front());
+        mix(feature.back());
+        return key;
+    }
+
+    /// Writes the projection of the samples onto each normal, projection p of sample i
+    /// to projections[p * n + i]. Each tile of samples is transposed into a buffer so
+    /// that the innermost loop runs over the samples of the tile with a broadcast
+    /// normal component, which vectorises without reordering the sum over the
+    /// dimensions, and the tile is reused from cache for every normal.
+    template <typename feature_t>
+    static void project(const feature_t& feature, const std::vector<double>& normals,
+        std::size_t n_features, std::span<double> projections)
+    {
+        std::size_t n = std::ranges::size(feature);
+        std::size_t n_projections = normals.size() / n_features;
+
+        std::pmr::vector<double> tile(n_features * tile_size, &scratch_arena());
+        std::array<double, tile_size> sums;
+
+        for (std::size_t first = 0; first < n; first += tile_size) {
+            std::size_t size = std::min(tile_size, n - first);
+
+            for (std::size_t i = 0; i < size; ++i) {
+                const auto& sample = feature[first + i];
+                for (std::size_t d = 0; d < n_features; ++d)
+                    tile[d * tile_size + i] = sample[d];
+            }
+
+            for (std::size_t p = 0; p < n_projections; ++p) {
+                const double* normal = normals.data() + p * n_features;
+                sums.fill(0.0);
+                for (std::size_t d = 0; d < n_features; ++d) {
+                    const double* values = tile.data() + d * tile_size;
+                    for (std::size_t i = 0; i < tile_size; ++i)
+                        sums[i] += values[i] * normal[d];
+                }
+                std::copy_n(begin(sums), size, begin(projections) + p * n + first);
+            }
+        }
+    }
+
+    random_hyperplane_config m_config;
 
     base_algo_t m_base_algo;
 };
@@ -1,25 +1,48 @@
 #pragma once
 
 #include <algorithm>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <ranges>
+#include <span>
+#include <type_traits>
 #include <vector>
 
 #include "dtree/algos/cost_utils.h"
+#include "dtree/arena.h"
+#include "dtree/binning.h"
 #include "dtree/concepts.h"
 #include "dtree/labels.h"
 #include "dtree/splittings.h"
 
 namespace dtree::algos {
 
-class optimal_split {
+/// basic_optimal_split
+///
+/// Finds the threshold of a single numeric feature with the lowest cost by sorting the
+/// samples and scanning every threshold between distinct values. n_classes_ fixes the
+/// number of labels at compile time so the scan counts them in a std::array, and with
+/// two classes gini_impurity and entropy_impurity are evaluated in closed form (see
+/// fixed_cost_fn_c). Trees built with two classes have binary_leaf leaves. The default
+/// of 0 takes the number of labels from the labels.
+template <std::size_t n_classes_ = 0> class basic_optimal_split {
 public:
     using splitting_type = single_numeric_splitting;
 
-    template <single_numeric_feature_c feature_t, cost_fn_c cost_fn_t>
+    static constexpr std::size_t n_classes = n_classes_;
+
+    template <single_numeric_feature_c feature_t, labels_c labels_t,
+        cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> operator()(
-        const feature_t& feature, const labels& labels, cost_fn_t&& cost_fn) const
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
     {
-        using value_t = std::pair<double, labels::label_t>;
-        std::vector<value_t> data;
+        // The labels are sorted along with the values, padding each pair to 16 bytes.
+        // Sorting an index and gathering separate value and label arrays reads the
+        // feature out of order, and is slower once the node outgrows the cache.
+        using value_t = std::pair<double, typename labels_t::label_t>;
+        scratch_scope scope;
+        std::pmr::vector<value_t> data { scope.resource() };
         data.reserve(labels.size());
 
         for (std::size_t i = 0; i < labels.size(); ++i) {
@@ -27,30 +50,79 @@ public:
         }
 
         std::sort(begin(data), end(data));
-        label_counts counts_above = labels.get_label_counts();
-        label_counts counts_below(counts_above.size(), 0u);
 
-        std::size_t total_below = 0u, total_above = labels.size();
+        return split_sorted(data, labels.get_label_counts(), cost_fn);
+    }
+
+    /// Finds the best split from samples that are already ordered by value. The data
+    /// is a random access range of (value, label) pairs and the counts are the label
+    /// counts over the whole range. This is a single linear scan, and with an
+    /// incremental_cost_fn_c each step of it is O(1), as it is with a fixed number of
+    /// classes.
+    template <std::ranges::random_access_range data_t, cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> split_sorted(
+        const data_t& data, label_counts counts_above, cost_fn_t&& cost_fn) const
+    {
+        if constexpr (n_classes != 0) {
+            return split_sorted_fixed(
+                data, to_fixed_counts<n_classes>(counts_above), cost_fn);
+        } else {
+            std::size_t n = std::ranges::size(data);
+
+            double current_split = std::numeric_limits<double>::min();
+            double best_cost = cost_fn(counts_above);
+
+            split_scan<std::remove_cvref_t<cost_fn_t>> scan { cost_fn,
+                std::move(counts_above) };
+
+            for (std::size_t i = 0; i < n - 1; ++i) {
+                auto [z1, label] = data[i];
+
+                scan.move_below(label);
+
+                double z2 = std::get<0>(data[i + 1]);
+                if (z1 == z2)
+                    continue;
+
+                double cost = scan.cost();
+
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    current_split = 0.5 * (z2 + z1);
+                }
+            }
+
+            return { best_cost, single_numeric_splitting { current_split } };
+        }
+    }
+
+private:
+    template <typename data_t, typename cost_fn_t>
+    std::pair<double, splitting_type> split_sorted_fixed(const data_t& data,
+        fixed_label_counts<n_classes> counts_above, const cost_fn_t& cost_fn) const
+    {
+        std::size_t n = std::ranges::size(data);
+
+        fixed_label_counts<n_classes> counts_below {};
+        std::size_t total_below = 0u;
+        double total_count = n;
 
-        double total_count = labels.size();
         double current_split = std::numeric_limits<double>::min();
-        double best_cost = cost_fn(counts_above);
+        double best_cost = fixed_cost(cost_fn, counts_above);
 
-        for (std::size_t i = 0; i < labels.size() - 1; ++i) {
+        for (std::size_t i = 0; i < n - 1; ++i) {
             auto [z1, label] = data[i];
 
             counts_below[label]++;
             counts_above[label]--;
-
             total_below++;
-            total_above--;
 
             double z2 = std::get<0>(data[i + 1]);
             if (z1 == z2)
                 continue;
 
-            double cost = (total_below / total_count) * cost_fn(counts_below)
-                + (total_above / total_count) * cost_fn(counts_above);
+            double cost = (total_below / total_count) * fixed_cost(cost_fn, counts_below)
+                + ((n - total_below) / total_count) * fixed_cost(cost_fn, counts_above);
 
             if (cost < best_cost) {
                 best_cost = cost;
@@ -62,24 +134,177 @@ public:
     }
 };
 
+using optimal_split = basic_optimal_split<>;
+
+/// median_split
+///
+/// Splits a single numeric feature at its median, found by selection rather than a
+/// sort. Above sample_limit samples the median is estimated from sample_limit of them
+/// and never copies the whole feature. The node is cut into sample_limit strides and
+/// one sample is drawn at random from each, from a generator seeded with the number of
+/// samples so a build is repeatable. Being random the estimate is within a rank of
+/// about n / sqrt(sample_limit) of the true median whatever the order of the samples,
+/// where a fixed stride would follow any period in it. A sample_limit of 0 always
+/// takes the exact median.
 class median_split {
 public:
     using splitting_type = single_numeric_splitting;
 
-    template <single_numeric_feature_c feature_t, cost_fn_c cost_fn_t>
+    median_split()
+        : m_sample_limit { 0u }
+    {
+    }
+
+    explicit median_split(std::size_t sample_limit)
+        : m_sample_limit { sample_limit }
+    {
+    }
+
+    template <single_numeric_feature_c feature_t, labels_c labels_t,
+        cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> operator()(
-        const feature_t& feature, const labels& labels, cost_fn_t&& cost_fn) const
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
     {
-        std::vector<double> data(begin(feature), end(feature));
-        std::sort(begin(data), end(data));
+        scratch_scope scope;
+        std::pmr::vector<double> data { scope.resource() };
 
         std::size_t n = labels.size();
-        double split
-            = n % 2 == 1 ? data[n / 2] : 0.5 * (data[n / 2] + data[(n / 2) - 1]);
+        if (m_sample_limit != 0 && n > m_sample_limit) {
+            data.reserve(m_sample_limit);
+            std::mt19937 gen { static_cast<unsigned int>(n) };
+            for (std::size_t i = 0; i < m_sample_limit; ++i) {
+                std::uniform_int_distribution<std::size_t> dist { i * n / m_sample_limit,
+                    (i + 1) * n / m_sample_limit - 1 };
+                data.push_back(feature[dist(gen)]);
+            }
+        } else {
+            data.assign(begin(feature), end(feature));
+        }
 
-        splitting_type splitting { split };
+        splitting_type splitting { median(data) };
         return { calculate_cost(splitting, feature, labels, cost_fn), splitting };
     }
+
+    /// As optimal_split::split_sorted. The samples below the median are a prefix of
+    /// the data so the cost only needs a scan up to the median.
+    template <std::ranges::random_access_range data_t, cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> split_sorted(
+        const data_t& data, label_counts counts_above, cost_fn_t&& cost_fn) const
+    {
+        std::size_t n = std::ranges::size(data);
+        double split = n % 2 == 1
+            ? std::get<0>(data[n / 2])
+            : 0.5 * (std::get<0>(data[n / 2]) + std::get<0>(data[(n / 2) - 1]));
+
+        splitting_type splitting { split };
+        label_counts counts_below(counts_above.size(), 0u);
+
+        std::size_t total_below = 0u;
+        for (; total_below < n; ++total_below) {
+            auto [z, label] = data[total_below];
+            if (!splitting(z))
+                break;
+
+            counts_below[label]++;
+            counts_above[label]--;
+        }
+
+        double total_count = n;
+        double cost = ((n - total_below) / total_count) * cost_fn(counts_above)
+            + (total_below / total_count) * cost_fn(counts_below);
+
+        return { cost, splitting };
+    }
+
+private:
+    /// The median of the data, which is reordered. For an even number the two middle
+    /// values are averaged, the larger by selection and the smaller as the largest of
+    /// the values selection leaves below it.
+    static double median(std::span<double> data)
+    {
+        std::size_t n = data.size();
+        auto middle = begin(data) + n / 2;
+        std::nth_element(begin(data), middle, end(data));
+        if (n % 2 == 1)
+            return *middle;
+
+        return 0.5 * (*middle + *std::max_element(begin(data), middle));
+    }
+
+    std::size_t m_sample_limit;
+};
+
+/// histogram_split
+///
+/// Finds the best split of a binned feature by counting the labels in each bin and
+/// scanning the bins, so a node costs O(n + bins * labels) rather than a sort. The
+/// split thresholds are bin edges, so the optimum is over the bin boundaries only.
+class histogram_split {
+public:
+    using splitting_type = single_numeric_splitting;
+
+    template <labels_c labels_t, cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> operator()(
+        const binned_feature& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
+    {
+        return split_histogram(
+            label_histogram { feature, labels }, feature.edges(), cost_fn);
+    }
+
+    template <cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> split_histogram(const label_histogram& histogram,
+        const std::vector<double>& edges, cost_fn_t&& cost_fn) const
+    {
+        std::size_t n_bins = histogram.number_of_bins();
+        std::size_t n_labels = histogram.number_of_labels();
+
+        label_counts counts_above(n_labels, 0u);
+        std::vector<std::size_t> bin_totals(n_bins, 0u);
+        for (std::size_t bin = 0; bin < n_bins; ++bin) {
+            for (std::size_t label = 0; label < n_labels; ++label) {
+                counts_above[label] += histogram(bin, label);
+                bin_totals[bin] += histogram(bin, label);
+            }
+        }
+
+        // the histogram may cover more labels than the node holds, the counts passed
+        // to the cost function only go up to the largest label seen as with labels
+        while (!counts_above.empty() && counts_above.back() == 0)
+            counts_above.pop_back();
+        n_labels = counts_above.size();
+
+        std::size_t total_above
+            = std::accumulate(begin(bin_totals), end(bin_totals), std::size_t { 0 });
+
+        double current_split = std::numeric_limits<double>::min();
+        double best_cost = cost_fn(counts_above);
+
+        split_scan<std::remove_cvref_t<cost_fn_t>> scan { cost_fn,
+            std::move(counts_above) };
+
+        // only the boundary after a non empty bin that has samples above it is a
+        // candidate, the same as optimal_split only splitting between distinct values
+        for (std::size_t bin = 0; bin < n_bins && total_above > bin_totals[bin]; ++bin) {
+            if (bin_totals[bin] == 0)
+                continue;
+
+            for (std::size_t label = 0; label < n_labels; ++label) {
+                if (std::size_t count = histogram(bin, label))
+                    scan.move_below(label, count);
+            }
+
+            total_above -= bin_totals[bin];
+
+            double cost = scan.cost();
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                current_split = edges[bin];
+            }
+        }
+
+        return { best_cost, single_numeric_splitting { current_split } };
+    }
 };
 
 } // dtree::algos
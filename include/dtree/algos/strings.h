@@ -1,11 +1,21 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <random>
 #include <ranges>
-#include <unordered_set>
+#include <string>
 
+#include "dtree/aho_corasick.h"
+#include "dtree/algos/cost_utils.h"
+#include "dtree/arena.h"
 #include "dtree/concepts.h"
 #include "dtree/labels.h"
 #include "dtree/splittings.h"
+#include "dtree/suffix_automaton.h"
 
 namespace dtree::algos {
 
@@ -13,9 +23,9 @@ template <typename base_algo_t> class string_length_split {
 public:
     using splitting_type = string_length_splitting;
 
-    template <string_feature_c feature_t, cost_fn_c cost_fn_t>
+    template <string_feature_c feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> operator()(
-        const feature_t& feature, const labels& labels, cost_fn_t&& cost_fn) const
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
     {
         auto [cost, splitting] = m_base_algo(
             feature | std::views::transform([](auto&& s) { return s.size(); }), labels,
@@ -30,30 +40,216 @@ private:
     base_algo_t m_base_algo;
 };
 
+/// substring_split
+///
+/// Splits a string feature on whether the samples contain a substring from a corpus,
+/// choosing the substring with the lowest cost. The corpus is compiled once into an
+/// aho_corasick automaton, shared between copies of the algo, and a node is a single
+/// scan of each sample that counts, for every substring, the samples of each label
+/// containing it. The costs of all the substrings then come from these counts, so a
+/// node is O(total length of the samples + corpus size * labels) rather than a pass
+/// over the samples for every substring. An empty corpus gives the empty substring
+/// at the cost of not splitting.
 class substring_split {
 public:
     using splitting_type = has_substring_splitting;
 
-    // TODO - this is incredibly inefficient
-    template <string_feature_c feature_t, cost_fn_c cost_fn_t>
+    template <std::ranges::input_range corpus_t>
+    explicit substring_split(const corpus_t& corpus)
+        : m_corpus { std::make_shared<const aho_corasick>(corpus) }
+    {
+    }
+
+    template <string_feature_c feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
     std::pair<double, splitting_type> operator()(
-        const feature_t& feature, const labels& labels, cost_fn_t&& cost_fn) const
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
     {
+        const aho_corasick& corpus = *m_corpus;
+        std::size_t n = labels.size();
+        const label_counts& counts = labels.get_label_counts();
+        std::size_t n_labels = counts.size();
+
+        scratch_scope scope;
+        // the number of samples of each label containing each substring
+        std::pmr::vector<std::size_t> hits(corpus.size() * n_labels, scope.resource());
+        std::pmr::vector<std::uint32_t> visited(
+            corpus.number_of_states(), 0u, scope.resource());
+
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t label = labels[i];
+            const std::string& sample = feature[i];
+            corpus.for_each_pattern(sample, visited, static_cast<std::uint32_t>(i + 1),
+                [&hits, label, n_labels](
+                    std::uint32_t id) { hits[id * n_labels + label]++; });
+        }
+
+        label_counts counts_above(n_labels, 0u);
+        label_counts counts_below(n_labels, 0u);
+        double total_count = n;
+
         double best_cost = std::numeric_limits<double>::max();
-        splitting_type best_splitting;
-        for (const auto& sstring : m_corpus) {
-            splitting_type splitting { sstring };
-            if (double cost = calculate_cost(splitting, feature, labels, cost_fn);
-                cost < best_cost) {
+        std::size_t best_id = 0u;
+        for (std::size_t id = 0; id < corpus.size(); ++id) {
+            std::size_t total_below = 0u;
+            for (std::size_t label = 0; label < n_labels; ++label) {
+                counts_below[label] = hits[id * n_labels + label];
+                counts_above[label] = counts[label] - counts_below[label];
+                total_below += counts_below[label];
+            }
+
+            double cost = ((n - total_below) / total_count) * cost_fn(counts_above)
+                + (total_below / total_count) * cost_fn(counts_below);
+            if (cost < best_cost) {
                 best_cost = cost;
-                best_splitting = splitting;
+                best_id = id;
             }
         }
-        return { best_cost, best_splitting };
+
+        if (corpus.size() == 0)
+            return { cost_fn(counts), splitting_type {} };
+        return { best_cost, splitting_type { corpus[best_id] } };
+    }
+
+private:
+    std::shared_ptr<const aho_corasick> m_corpus;
+};
+
+struct substring_mining_config {
+    /// the fewest samples either side of a split
+    std::size_t min_support = 1u;
+    /// the longest substring tried
+    std::size_t max_length = 64u;
+    /// the most samples mined, 0 for all of them
+    std::size_t sample_limit = 0u;
+};
+
+/// mined_substring_split
+///
+/// Splits a string feature on whether the samples contain a substring, as with
+/// substring_split, but mines the substrings from the samples of the node rather than
+/// taking a corpus. The samples are built into a suffix_automaton, whose states group
+/// the substrings by the samples they occur in, and one walk of each sample counts,
+/// for every state, the samples of each label containing its substrings. Every
+/// distinct substring is then costed from these counts, a state at a time, and the
+/// shortest substring of the best state is the split. Every state is visited in one
+/// linear pass, those outside the support and length limits being skipped rather
+/// than costed. When no state is within them the split is the empty substring at the
+/// cost of not splitting, as with substring_split and an empty corpus.
+///
+/// The automaton and the counts grow with the total length of the samples mined, so
+/// above sample_limit samples only sample_limit of them are mined, drawn one from each
+/// stride of the node as in median_split. The support limits are then taken on the
+/// share of the node each substring is estimated to split off, and only the cost of
+/// the chosen substring is taken over every sample.
+class mined_substring_split {
+public:
+    using splitting_type = has_substring_splitting;
+
+    mined_substring_split()
+        : m_config {}
+    {
+    }
+
+    explicit mined_substring_split(substring_mining_config config)
+        : m_config { config }
+    {
+    }
+
+    template <string_feature_c feature_t, labels_c labels_t, cost_fn_c cost_fn_t>
+    std::pair<double, splitting_type> operator()(
+        const feature_t& feature, const labels_t& labels, cost_fn_t&& cost_fn) const
+    {
+        std::size_t n = labels.size();
+        const label_counts& counts = labels.get_label_counts();
+        std::size_t n_labels = counts.size();
+
+        scratch_scope scope;
+        // the samples mined and the number of each label among them
+        std::pmr::vector<std::size_t> mined { scope.resource() };
+        label_counts mined_counts;
+        bool sampled = m_config.sample_limit != 0 && n > m_config.sample_limit;
+        if (sampled) {
+            std::size_t limit = m_config.sample_limit;
+            mined.reserve(limit);
+            mined_counts.assign(n_labels, 0u);
+            std::mt19937 gen { static_cast<unsigned int>(n) };
+            for (std::size_t i = 0; i < limit; ++i) {
+                std::uniform_int_distribution<std::size_t> dist { i * n / limit,
+                    (i + 1) * n / limit - 1 };
+                mined.push_back(dist(gen));
+                mined_counts[labels[mined.back()]]++;
+            }
+        } else {
+            mined.resize(n);
+            std::iota(begin(mined), end(mined), std::size_t { 0 });
+            mined_counts = counts;
+        }
+        std::size_t m = mined.size();
+
+        suffix_automaton automaton;
+        for (std::size_t i : mined) {
+            const std::string& sample = feature[i];
+            automaton.add(sample, i);
+        }
+        std::size_t n_states = automaton.number_of_states();
+
+        // the number of samples of each label containing the substrings of each state
+        std::pmr::vector<std::size_t> hits(n_states * n_labels, scope.resource());
+        std::pmr::vector<std::uint32_t> visited(n_states, 0u, scope.resource());
+
+        for (std::size_t j = 0; j < m; ++j) {
+            std::size_t label = labels[mined[j]];
+            const std::string& sample = feature[mined[j]];
+            automaton.for_each_state(sample, visited, static_cast<std::uint32_t>(j + 1),
+                [&hits, label, n_labels](
+                    std::uint32_t state) { hits[state * n_labels + label]++; });
+        }
+
+        label_counts counts_above(n_labels, 0u);
+        label_counts counts_below(n_labels, 0u);
+        double total_count = m;
+
+        double best_cost = std::numeric_limits<double>::max();
+        std::uint32_t best_state = 0u;
+        for (std::uint32_t state = 1; state < n_states; ++state) {
+            if (automaton.length(automaton.link(state)) >= m_config.max_length)
+                continue;
+
+            // the support limits are on the node, of which the mined samples are m / n
+            std::size_t total_below = 0u;
+            for (std::size_t label = 0; label < n_labels; ++label)
+                total_below += hits[state * n_labels + label];
+            if (total_below * n < m_config.min_support * m
+                || (m - total_below) * n < m_config.min_support * m)
+                continue;
+
+            for (std::size_t label = 0; label < n_labels; ++label) {
+                counts_below[label] = hits[state * n_labels + label];
+                counts_above[label] = mined_counts[label] - counts_below[label];
+            }
+
+            double cost = ((m - total_below) / total_count) * cost_fn(counts_above)
+                + (total_below / total_count) * cost_fn(counts_below);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_state = state;
+            }
+        }
+
+        if (best_state == 0)
+            return { cost_fn(counts), splitting_type {} };
+
+        auto [id, end] = automaton.end(best_state);
+        std::size_t length = automaton.length(automaton.link(best_state)) + 1;
+        const std::string& sample = feature[id];
+        splitting_type splitting { sample.substr(end + 1 - length, length) };
+        if (sampled)
+            best_cost = calculate_cost(splitting, feature, labels, cost_fn);
+        return { best_cost, splitting };
     }
 
 private:
-    const std::unordered_set<std::string>& m_corpus;
+    substring_mining_config m_config;
 };
 
 } // dtree::algos
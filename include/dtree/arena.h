@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace dtree {
+
+/// arena_resource
+///
+/// A memory resource that hands out memory by bumping a pointer through a list of
+/// blocks and never frees individual allocations. Instead the arena is rewound to an
+/// earlier mark, which frees everything allocated since at once while keeping the
+/// blocks for reuse, so once it has grown to the peak size of a build it stops
+/// allocating altogether.
+class arena_resource : public std::pmr::memory_resource {
+public:
+    struct marker {
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    explicit arena_resource(std::size_t block_size = 64 * 1024,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    ~arena_resource() override;
+
+    arena_resource(const arena_resource&) = delete;
+    arena_resource& operator=(const arena_resource&) = delete;
+
+    marker mark() const { return { m_current, m_offset }; }
+
+    /// Frees everything allocated since the mark was taken.
+    void rewind(marker mark);
+
+    /// Frees everything, keeping the blocks.
+    void reset() { rewind({ 0u, 0u }); }
+
+    /// The total size of the blocks held.
+    std::size_t capacity() const;
+
+private:
+    struct block {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    void do_deallocate(void*, std::size_t, std::size_t) override { }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::size_t m_block_size;
+
+    std::pmr::memory_resource* m_upstream;
+
+    std::vector<block> m_blocks;
+
+    std::size_t m_current;
+
+    std::size_t m_offset;
+};
+
+/// The arena of the calling thread, used for the temporaries of a build.
+arena_resource& scratch_arena();
+
+/// scratch_scope
+///
+/// Rewinds the calling thread's scratch arena to where it was when the scope was
+/// entered. The tree builder and algos open one per node, so their temporaries are
+/// freed together as the node finishes. Scopes nest like the recursion of the build,
+/// a task run on the thread while it waits for a sub tree being done before the wait
+/// returns, and anything allocated in a scope must be destroyed before it ends.
+class scratch_scope {
+public:
+    scratch_scope()
+        : m_arena { scratch_arena() }
+        , m_mark { m_arena.mark() }
+    {
+    }
+
+    ~scratch_scope() { m_arena.rewind(m_mark); }
+
+    scratch_scope(const scratch_scope&) = delete;
+    scratch_scope& operator=(const scratch_scope&) = delete;
+
+    std::pmr::memory_resource* resource() const { return &m_arena; }
+
+private:
+    arena_resource& m_arena;
+
+    arena_resource::marker m_mark;
+};
+
+} // namespace dtree
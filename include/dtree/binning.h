@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <compare>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "dtree/concepts.h"
+#include "dtree/labels.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// binned_feature
+///
+/// A single numeric feature discretised into at most 255 bins. Each sample is stored as
+/// a one byte bin code and the bins are described by their increasing upper edges,
+/// which are shared between a feature and all the features selected from it.
+/// Reading a sample gives back the upper edge of its bin. As `x <= edges[b]` holds
+/// exactly when the code of x is at most b, the edges can be used directly as
+/// single_numeric_splitting thresholds, so a binned feature can be split (and a tree
+/// trained on it applied to raw values) like any other single numeric feature.
+class binned_feature {
+public:
+    using code_type = std::uint8_t;
+    using value_type = double;
+
+    static constexpr std::size_t max_bins = 255;
+
+    class iterator {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = double;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = double;
+
+        iterator() = default;
+
+        iterator(const code_type* code, const double* edges)
+            : m_code { code }
+            , m_edges { edges }
+        {
+        }
+
+        double operator*() const { return m_edges[*m_code]; }
+        double operator[](difference_type n) const { return m_edges[m_code[n]]; }
+
+        iterator& operator++()
+        {
+            ++m_code;
+            return *this;
+        }
+        iterator operator++(int) { return { m_code++, m_edges }; }
+        iterator& operator--()
+        {
+            --m_code;
+            return *this;
+        }
+        iterator operator--(int) { return { m_code--, m_edges }; }
+
+        iterator& operator+=(difference_type n)
+        {
+            m_code += n;
+            return *this;
+        }
+        iterator& operator-=(difference_type n)
+        {
+            m_code -= n;
+            return *this;
+        }
+
+        friend iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend difference_type operator-(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.m_code - rhs.m_code;
+        }
+
+        bool operator==(const iterator& other) const { return m_code == other.m_code; }
+        auto operator<=>(const iterator& other) const { return m_code <=> other.m_code; }
+
+    private:
+        const code_type* m_code = nullptr;
+        const double* m_edges = nullptr;
+    };
+
+    using const_iterator = iterator;
+
+    binned_feature()
+        : m_codes {}
+        , m_edges { std::make_shared<const std::vector<double>>() }
+    {
+    }
+
+    binned_feature(
+        std::vector<code_type> codes, std::shared_ptr<const std::vector<double>> edges)
+        : m_codes { std::move(codes) }
+        , m_edges { std::move(edges) }
+    {
+    }
+
+    iterator begin() const { return { m_codes.data(), m_edges->data() }; }
+    iterator end() const
+    {
+        return { m_codes.data() + m_codes.size(), m_edges->data() };
+    }
+
+    friend iterator begin(const binned_feature& feature) { return feature.begin(); }
+    friend iterator end(const binned_feature& feature) { return feature.end(); }
+
+    double operator[](std::size_t loc) const { return (*m_edges)[m_codes[loc]]; }
+
+    std::size_t size() const { return m_codes.size(); }
+
+    std::size_t number_of_bins() const { return m_edges->size(); }
+
+    const std::vector<code_type>& codes() const { return m_codes; }
+
+    const std::vector<double>& edges() const { return *m_edges; }
+
+    /// The samples at the given locations, sharing the bins of this feature.
+    binned_feature select(std::span<const std::size_t> index) const
+    {
+        std::vector<code_type> codes;
+        codes.reserve(index.size());
+        for (std::size_t i : index)
+            codes.push_back(m_codes[i]);
+        return { std::move(codes), m_edges };
+    }
+
+private:
+    std::vector<code_type> m_codes;
+
+    std::shared_ptr<const std::vector<double>> m_edges;
+};
+
+/// The upper edges of at most max_bins bins over the sorted values, chosen so each bin
+/// holds roughly the same number of samples. Runs of equal values are never split
+/// across bins, and an edge between two bins sits halfway between their values so
+/// when there are few enough distinct values each gets a bin and the edges are the
+/// same thresholds optimal_split would consider.
+std::vector<double> quantile_edges(
+    const std::vector<double>& sorted_values, std::size_t max_bins);
+
+template <single_numeric_feature_c feature_t>
+binned_feature make_binned_feature(
+    const feature_t& feature, std::size_t max_bins = binned_feature::max_bins)
+{
+    std::vector<double> values(begin(feature), end(feature));
+    std::sort(begin(values), end(values));
+    auto edges = std::make_shared<const std::vector<double>>(
+        quantile_edges(values, std::min(max_bins, binned_feature::max_bins)));
+
+    std::vector<binned_feature::code_type> codes;
+    codes.reserve(values.size());
+    for (double x : feature) {
+        auto it = std::lower_bound(begin(*edges), end(*edges), x);
+        codes.push_back(static_cast<binned_feature::code_type>(it - begin(*edges)));
+    }
+
+    return { std::move(codes), std::move(edges) };
+}
+
+/// label_histogram
+///
+/// The label counts of every bin of a binned feature, stored bin major. Building one
+/// is a single pass over the samples and the split search then only needs to look at
+/// the bins.
+class label_histogram {
+public:
+    label_histogram(std::size_t n_bins, std::size_t n_labels)
+        : m_n_labels { n_labels }
+        , m_counts(n_bins * n_labels, 0u)
+    {
+    }
+
+    template <labels_c labels_t>
+    label_histogram(const binned_feature& feature, const labels_t& labels_)
+        : label_histogram { feature.number_of_bins(), labels_.number_of_labels() }
+    {
+        const auto& codes = feature.codes();
+        for (std::size_t i = 0; i < codes.size(); ++i) {
+            m_counts[codes[i] * m_n_labels + labels_[i]]++;
+        }
+    }
+
+    bool operator==(const label_histogram&) const = default;
+
+    /// Empties the histogram for a feature with n_bins bins, reusing its storage.
+    void reset(std::size_t n_bins) { m_counts.assign(n_bins * m_n_labels, 0u); }
+
+    /// Counts the samples at the given locations.
+    template <labels_c labels_t, typename index_t>
+    void add(
+        const binned_feature& feature, const labels_t& labels_, const index_t& index)
+    {
+        const auto& codes = feature.codes();
+        for (std::size_t i : index) {
+            m_counts[codes[i] * m_n_labels + labels_[i]]++;
+        }
+    }
+
+    /// Counts a single sample.
+    void add(std::size_t bin, std::size_t label)
+    {
+        m_counts[bin * m_n_labels + label]++;
+    }
+
+    /// Removes the counts of a histogram over a subset of the samples of this one, so
+    /// the counts of one child of a node are its parent's less those of its sibling.
+    label_histogram& operator-=(const label_histogram& other)
+    {
+        for (std::size_t i = 0; i < m_counts.size(); ++i) {
+            m_counts[i] -= other.m_counts[i];
+        }
+        return *this;
+    }
+
+    std::size_t number_of_bins() const
+    {
+        return m_n_labels == 0 ? 0 : m_counts.size() / m_n_labels;
+    }
+
+    std::size_t number_of_labels() const { return m_n_labels; }
+
+    std::size_t operator()(std::size_t bin, std::size_t label) const
+    {
+        return m_counts[bin * m_n_labels + label];
+    }
+
+private:
+    std::size_t m_n_labels;
+
+    std::vector<std::size_t> m_counts;
+};
+
+template <typename T>
+concept binned_feature_set_c = std::same_as<typename T::mapped_type, binned_feature>;
+
+/// histogram_algo_c
+///
+/// An algo that can find a split of a binned feature from the label histogram of its
+/// bins. Using it the tree builder only scans the samples of the smaller child of a
+/// node and derives the histograms of the larger child by subtraction.
+template <typename algo_t, typename cost_fn_t>
+concept histogram_algo_c = requires(const algo_t& algo,
+    const label_histogram& histogram, const std::vector<double>& edges,
+    cost_fn_t cost_fn)
+{
+    algo.split_histogram(histogram, edges, cost_fn);
+};
+
+} // namespace dtree
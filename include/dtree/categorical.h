@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "dtree/concepts.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// category_dictionary
+///
+/// Interns strings to dense codes 0, ..., size() - 1 in the order they are first seen,
+/// so a categorical feature compares integers rather than strings.
+class category_dictionary {
+public:
+    static constexpr std::uint32_t unknown = UINT32_MAX;
+
+    /// The code of the string, giving it the next code if it is new.
+    std::uint32_t intern(std::string_view string);
+
+    /// The code of the string, unknown if it has not been interned.
+    std::uint32_t find(std::string_view string) const;
+
+    const std::string& operator[](std::uint32_t code) const { return m_strings[code]; }
+
+    std::size_t size() const { return m_strings.size(); }
+
+private:
+    struct string_hash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view string) const
+        {
+            return std::hash<std::string_view> {}(string);
+        }
+    };
+
+    std::vector<std::string> m_strings;
+
+    std::unordered_map<std::string, std::uint32_t, string_hash, std::equal_to<>> m_codes;
+};
+
+/// categorical_feature
+///
+/// A string feature encoded once as the codes of a category_dictionary, which is shared
+/// between a feature and all the features selected from it. Samples read as
+/// dtree::category, so it is split by the categorical algos (see
+/// dtree::algos::category_split) and its splittings are bitsets over the codes.
+class categorical_feature {
+public:
+    using value_type = category;
+    using const_iterator = std::vector<category>::const_iterator;
+    using iterator = const_iterator;
+
+    categorical_feature()
+        : m_categories {}
+        , m_dictionary { std::make_shared<const category_dictionary>() }
+    {
+    }
+
+    categorical_feature(std::vector<category> categories,
+        std::shared_ptr<const category_dictionary> dictionary)
+        : m_categories { std::move(categories) }
+        , m_dictionary { std::move(dictionary) }
+    {
+    }
+
+    const_iterator begin() const { return m_categories.begin(); }
+    const_iterator end() const { return m_categories.end(); }
+
+    friend const_iterator begin(const categorical_feature& feature)
+    {
+        return feature.begin();
+    }
+    friend const_iterator end(const categorical_feature& feature)
+    {
+        return feature.end();
+    }
+
+    category operator[](std::size_t loc) const { return m_categories[loc]; }
+
+    std::size_t size() const { return m_categories.size(); }
+
+    std::size_t number_of_categories() const { return m_dictionary->size(); }
+
+    const std::vector<category>& categories() const { return m_categories; }
+
+    const category_dictionary& dictionary() const { return *m_dictionary; }
+
+    const std::shared_ptr<const category_dictionary>& shared_dictionary() const
+    {
+        return m_dictionary;
+    }
+
+    /// The samples at the given locations, sharing the dictionary of this feature.
+    categorical_feature select(std::span<const std::size_t> index) const
+    {
+        std::vector<category> categories;
+        categories.reserve(index.size());
+        for (std::size_t i : index)
+            categories.push_back(m_categories[i]);
+        return { std::move(categories), m_dictionary };
+    }
+
+private:
+    std::vector<category> m_categories;
+
+    std::shared_ptr<const category_dictionary> m_dictionary;
+};
+
+/// Encodes a string feature with a new dictionary of its distinct strings.
+template <string_feature_c feature_t>
+categorical_feature make_categorical_feature(const feature_t& feature)
+{
+    auto dictionary = std::make_shared<category_dictionary>();
+
+    std::vector<category> categories;
+    categories.reserve(std::ranges::size(feature));
+    for (const auto& sample : feature) {
+        const std::string& string = sample;
+        categories.push_back({ dictionary->intern(string) });
+    }
+
+    return { std::move(categories), std::move(dictionary) };
+}
+
+/// Encodes a string feature with the dictionary of a feature trained on, e.g. to apply
+/// a tree to new samples. Strings not in the dictionary are unknown.
+template <string_feature_c feature_t>
+categorical_feature make_categorical_feature(
+    const feature_t& feature, std::shared_ptr<const category_dictionary> dictionary)
+{
+    std::vector<category> categories;
+    categories.reserve(std::ranges::size(feature));
+    for (const auto& sample : feature) {
+        const std::string& string = sample;
+        categories.push_back({ dictionary->find(string) });
+    }
+
+    return { std::move(categories), std::move(dictionary) };
+}
+
+} // namespace dtree
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+
+#include "dtree/flat_tree.h"
+#include "dtree/splittings.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+struct codegen_config {
+    /// the namespace of the generated function
+    std::string namespace_name = "dtree_model";
+    /// the name of the generated function
+    std::string function_name = "score";
+};
+
+/// Writes a double as a C++ literal that reads back as the same value.
+void write_literal(std::ostream& out, double value);
+
+/// Writes the opening of a generated header, up to the signature of the function
+/// returning the given type.
+void write_cpp_prologue(
+    std::ostream& out, const codegen_config& config, std::string_view return_type);
+
+/// Writes the closing of a generated header.
+void write_cpp_epilogue(std::ostream& out, const codegen_config& config);
+
+/// write_cpp
+///
+/// Writes a header defining the tree as a constexpr function of a sample, anything
+/// indexable by feature id, that nests an if for each split with its threshold as an
+/// immediate and returns the value of each leaf as a literal: the probability of label
+/// 1 for a binary_leaf, otherwise a std::array of the label probabilities padded with
+/// zeros to the largest distribution. Compiled into a static model it does none of the
+/// variant visits or leaf indirections of flat_tree::apply.
+template <typename leaf_t>
+void write_cpp(std::ostream& out,
+    const flat_tree<node<single_numeric_splitting>, leaf_t>& tree,
+    const codegen_config& config = {})
+{
+    using split_t = node<single_numeric_splitting>;
+
+    std::size_t width = 1u;
+    if constexpr (!std::is_same_v<leaf_t, binary_leaf>) {
+        for (const auto& node : tree.data()) {
+            if (const auto* leaf = std::get_if<leaf_t>(&node))
+                width = std::max(width, leaf->value().size());
+        }
+    }
+
+    if constexpr (std::is_same_v<leaf_t, binary_leaf>)
+        write_cpp_prologue(out, config, "double");
+    else
+        write_cpp_prologue(
+            out, config, "std::array<double, " + std::to_string(width) + ">");
+
+    auto write_node = [&](auto& self, std::size_t loc, std::size_t depth) -> void {
+        std::string indent(4 * depth, ' ');
+        if (const auto* split = std::get_if<split_t>(&tree[loc])) {
+            out << indent << "if (sample[" << split->feature_id_ << "] <= ";
+            write_literal(out, split->splitting.split);
+            out << ") {\n";
+            self(self, tree.next(true, loc), depth + 1);
+            out << indent << "} else {\n";
+            self(self, tree.next(false, loc), depth + 1);
+            out << indent << "}\n";
+            return;
+        }
+
+        const auto& leaf = std::get<leaf_t>(tree[loc]);
+        out << indent << "return ";
+        if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+            write_literal(out, leaf.probability());
+        } else {
+            out << "{ ";
+            const auto& distribution = leaf.value();
+            for (std::size_t label = 0; label < width; ++label) {
+                if (label != 0)
+                    out << ", ";
+                write_literal(
+                    out, label < distribution.size() ? distribution[label] : 0.0);
+            }
+            out << " }";
+        }
+        out << ";\n";
+    };
+    if (tree.data().empty())
+        out << "    return {};\n";
+    else
+        write_node(write_node, 0u, 1u);
+
+    write_cpp_epilogue(out, config);
+}
+
+} // namespace dtree
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "dtree/flat_tree.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// compact_node
+///
+/// A node of a compact_tree. The split holds the node's splitting when it fits in 8
+/// bytes, otherwise the position of its splitting in the tree's pool of them. A split
+/// node's lower child is at child and its upper child next to it. A leaf has no
+/// feature and child is the position of its value in the tree's pool of values.
+template <typename payload_t> struct compact_node {
+    static constexpr std::uint32_t no_feature = UINT32_MAX;
+
+    bool operator==(const compact_node&) const = default;
+
+    bool is_leaf() const { return feature_id == no_feature; }
+
+    alignas(8) payload_t split;
+    std::uint32_t feature_id;
+    std::uint32_t child;
+};
+
+/// compact_tree
+///
+/// A tree holding only the nodes a flat_tree reaches, in breadth first order (or the
+/// order of van_emde_boas_layout) with the children of a node next to each other, so
+/// it takes memory in proportion to its number of nodes rather than to 2^depth. The
+/// nodes are 16 bytes, four to a cache line, and the values of the leaves are pooled
+/// in one array of a row per leaf rather than a vector each. A tree is built as a
+/// flat_tree and converted to this for inference.
+template <typename split_t, typename leaf_t> class compact_tree {
+    using splitting_t = decltype(split_t::splitting);
+
+    // a splitting such as a threshold is held in its node, others are pooled
+    static constexpr bool inline_splitting
+        = sizeof(splitting_t) <= 8 && std::is_trivially_copyable_v<splitting_t>;
+
+public:
+    using leaf_type = leaf_t;
+
+    using size_type = std::uint32_t;
+
+    using node_type
+        = compact_node<std::conditional_t<inline_splitting, splitting_t, std::uint64_t>>;
+
+    /// The value of a leaf, the probability of label 1 for a binary_leaf and otherwise
+    /// its distribution, padded with zeros to the width of the tree.
+    using value_type = std::conditional_t<std::is_same_v<leaf_t, binary_leaf>, double,
+        std::span<const double>>;
+
+    static_assert(sizeof(node_type) == 16);
+
+    compact_tree()
+        : m_nodes {}
+        , m_splittings {}
+        , m_values {}
+        , m_width { 1u }
+    {
+    }
+
+    explicit compact_tree(const flat_tree<split_t, leaf_t>& tree)
+        : m_nodes {}
+        , m_splittings {}
+        , m_values {}
+        , m_width { 1u }
+    {
+        if (tree.data().empty())
+            return;
+
+        // node i is at flat_locs[i] in the flat_tree, and its children are appended
+        // as it is visited so that they are next to each other
+        std::vector<std::size_t> flat_locs { 0u };
+        std::vector<const leaf_t*> leaves;
+        for (std::size_t i = 0; i < flat_locs.size(); ++i) {
+            std::size_t loc = flat_locs[i];
+            node_type node {};
+            if (const auto* split = std::get_if<split_t>(&tree[loc])) {
+                if (split->feature_id_ >= node_type::no_feature) {
+                    std::stringstream msg;
+                    msg << "Feature " << split->feature_id_
+                        << " is beyond the features a compact_tree can split on";
+                    throw std::runtime_error { msg.str() };
+                }
+                node.feature_id = static_cast<std::uint32_t>(split->feature_id_);
+                node.child = static_cast<size_type>(flat_locs.size());
+                if constexpr (inline_splitting) {
+                    node.split = split->splitting;
+                } else {
+                    node.split = m_splittings.size();
+                    m_splittings.push_back(split->splitting);
+                }
+                flat_locs.push_back(tree.next(true, loc));
+                flat_locs.push_back(tree.next(false, loc));
+            } else {
+                node.feature_id = node_type::no_feature;
+                node.child = static_cast<size_type>(leaves.size());
+                leaves.push_back(&std::get<leaf_t>(tree[loc]));
+            }
+            m_nodes.push_back(node);
+        }
+
+        if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+            for (const auto* leaf : leaves)
+                m_values.push_back(leaf->value());
+        } else {
+            for (const auto* leaf : leaves) {
+                auto size = static_cast<size_type>(leaf->value().size());
+                m_width = std::max(m_width, size);
+            }
+            m_values.resize(leaves.size() * m_width, 0.0);
+            for (std::size_t l = 0; l < leaves.size(); ++l)
+                std::ranges::copy(leaves[l]->value(), m_values.begin() + l * m_width);
+        }
+    }
+
+    compact_tree(std::vector<node_type> nodes, std::vector<splitting_t> splittings,
+        std::vector<double> values, size_type width)
+        : m_nodes { std::move(nodes) }
+        , m_splittings { std::move(splittings) }
+        , m_values { std::move(values) }
+        , m_width { width }
+    {
+    }
+
+    bool operator==(const compact_tree&) const = default;
+
+    const node_type& operator[](size_type loc) const { return m_nodes[loc]; }
+
+    size_type size() const { return static_cast<size_type>(m_nodes.size()); }
+
+    /// The number of values in the row of a leaf.
+    size_type width() const { return m_width; }
+
+    const std::vector<node_type>& nodes() const { return m_nodes; }
+
+    /// The pooled splittings, empty when they are held in the nodes.
+    const std::vector<splitting_t>& splittings() const { return m_splittings; }
+
+    /// The pooled values of the leaves, a row of width() per leaf.
+    const std::vector<double>& values() const { return m_values; }
+
+    const splitting_t& splitting(const node_type& node) const
+    {
+        if constexpr (inline_splitting)
+            return node.split;
+        else
+            return m_splittings[node.split];
+    }
+
+    /// The value of a leaf node.
+    value_type value(const node_type& node) const
+    {
+        if constexpr (std::is_same_v<leaf_t, binary_leaf>)
+            return m_values[node.child];
+        else
+            return { m_values.data() + std::size_t { node.child } * m_width, m_width };
+    }
+
+    /// The location of the leaf the sample reaches.
+    template <typename sample_t> size_type find_leaf(const sample_t& sample) const
+    {
+        size_type loc = 0;
+        while (!m_nodes[loc].is_leaf()) {
+            const auto& node = m_nodes[loc];
+            loc = node.child + (splitting(node)(sample[node.feature_id]) ? 0u : 1u);
+        }
+        return loc;
+    }
+
+    /// The value of the leaf the sample reaches.
+    template <typename sample_t> value_type apply(const sample_t& sample) const
+    {
+        return value(m_nodes[find_leaf(sample)]);
+    }
+
+private:
+    std::vector<node_type> m_nodes;
+
+    std::vector<splitting_t> m_splittings;
+
+    std::vector<double> m_values;
+
+    size_type m_width;
+};
+
+/// van_emde_boas_layout
+///
+/// The tree with its nodes reordered so that a path from the root touches few cache
+/// lines and pages whatever their sizes. In breadth first order each level of a deep
+/// tree is further from the last, so every step below the first few levels is a new
+/// line. Here the top half of the levels is laid out recursively, followed by each
+/// subtree hanging from it, also laid out recursively, so any subtree of around a
+/// line or a page of nodes is contiguous and a path crosses O(log_B n) blocks of B
+/// nodes rather than one per level. The unit laid out is a pair of siblings, which
+/// stay next to each other, and the child locations are rewritten to match. The
+/// splittings and the values keep their places in the pools.
+template <typename split_t, typename leaf_t>
+compact_tree<split_t, leaf_t> van_emde_boas_layout(
+    const compact_tree<split_t, leaf_t>& tree)
+{
+    using size_type = compact_tree<split_t, leaf_t>::size_type;
+
+    const auto& nodes = tree.nodes();
+    std::size_t n = nodes.size();
+    if (n == 0)
+        return tree;
+
+    // the levels below and including each node, the nodes being in an order where
+    // children come after their parent
+    std::vector<std::size_t> heights(n, 1u);
+    for (std::size_t loc = n; loc-- > 0;) {
+        if (!nodes[loc].is_leaf()) {
+            heights[loc]
+                = 1 + std::max(heights[nodes[loc].child], heights[nodes[loc].child + 1]);
+        }
+    }
+
+    // a unit is the root or a pair of siblings, given by its first location
+    auto unit_size = [](std::size_t first) { return first == 0 ? 1u : 2u; };
+    auto add_children = [&](std::size_t first, std::vector<std::size_t>& children) {
+        for (std::size_t loc = first; loc < first + unit_size(first); ++loc) {
+            if (!nodes[loc].is_leaf())
+                children.push_back(nodes[loc].child);
+        }
+    };
+
+    std::vector<size_type> new_locs(n);
+    size_type next_loc = 0;
+    auto layout = [&](auto& self, std::size_t first, std::size_t height) -> void {
+        if (height == 1) {
+            for (std::size_t loc = first; loc < first + unit_size(first); ++loc)
+                new_locs[loc] = next_loc++;
+            return;
+        }
+
+        std::size_t top_height = height / 2;
+        self(self, first, top_height);
+
+        std::vector<std::size_t> frontier { first };
+        std::vector<std::size_t> children;
+        for (std::size_t level = 0; level < top_height; ++level) {
+            children.clear();
+            for (std::size_t unit : frontier)
+                add_children(unit, children);
+            std::swap(frontier, children);
+        }
+        for (std::size_t unit : frontier)
+            self(self, unit, height - top_height);
+    };
+    layout(layout, 0u, heights[0]);
+
+    std::vector<typename compact_tree<split_t, leaf_t>::node_type> reordered(n);
+    for (std::size_t loc = 0; loc < n; ++loc) {
+        auto node = nodes[loc];
+        if (!node.is_leaf())
+            node.child = new_locs[node.child];
+        reordered[new_locs[loc]] = node;
+    }
+
+    return { std::move(reordered), tree.splittings(), tree.values(), tree.width() };
+}
+
+} // namespace dtree
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "dtree/dataset.h"
+#include "dtree/flat_tree.h"
+#include "dtree/splittings.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// Moves the samples of a column major batch, feature f of sample i being at
+/// data[f * stride + i], down a complete tree of the given depth whose split at loc
+/// is x[features[loc]] <= thresholds[loc], writing the bottom slot each reaches (its
+/// location less 2^depth - 1). Runs on the widest gathers the cpu supports.
+void find_complete_leaves(const std::uint32_t* features, const double* thresholds,
+    std::size_t depth, const double* data, std::size_t stride,
+    std::span<std::uint32_t> slots);
+
+/// complete_leaves_kernel
+///
+/// An implementation of find_complete_leaves for one instruction set.
+struct complete_leaves_kernel {
+    const char* name;
+    void (*find_leaves)(const std::uint32_t* features, const double* thresholds,
+        std::size_t depth, const double* data, std::size_t stride,
+        std::span<std::uint32_t> slots);
+};
+
+/// The kernels the cpu running the process supports, widest first, ending with the
+/// scalar one. find_complete_leaves uses the first.
+std::span<const complete_leaves_kernel> supported_complete_leaves_kernels();
+
+/// complete_tree
+///
+/// A tree of single numeric splits with every leaf at the same depth, the leaves of a
+/// flat_tree above its deepest level being pushed down by splits that send every
+/// sample the same way. Every sample then takes exactly depth steps of
+/// loc = 2 * loc + 1 + !(x <= t) with nothing to branch on, which avoids the
+/// mispredictions of noisy data and lets a batch descend several samples per
+/// instruction with gathers. The splits are held as separate arrays of features and
+/// thresholds and the padding doubles the nodes for every level a leaf is pushed down,
+/// so this suits shallow trees; flat_tree and compact_tree suit deep ones.
+template <typename leaf_t> class complete_tree {
+public:
+    using leaf_type = leaf_t;
+
+    using size_type = std::uint32_t;
+
+    using split_type = node<single_numeric_splitting>;
+
+    using value_type = std::conditional_t<std::is_same_v<leaf_t, binary_leaf>, double,
+        std::span<const double>>;
+
+    static constexpr std::size_t max_depth = 20;
+
+    complete_tree()
+        : m_depth { 0u }
+        , m_features {}
+        , m_thresholds {}
+        , m_leaves { 0u }
+        , m_values(1u, 0.0)
+        , m_width { 1u }
+        , m_n_features { 0u }
+    {
+    }
+
+    explicit complete_tree(const flat_tree<split_type, leaf_t>& tree)
+        : m_depth { 0u }
+        , m_features {}
+        , m_thresholds {}
+        , m_leaves {}
+        , m_values {}
+        , m_width { 1u }
+        , m_n_features { 0u }
+    {
+        if (tree.data().empty()) {
+            *this = complete_tree {};
+            return;
+        }
+
+        m_depth = depth_of(tree);
+        if (m_depth > max_depth) {
+            std::stringstream msg;
+            msg << "A tree of depth " << m_depth << " is deeper than a complete_tree of "
+                << "at most depth " << max_depth;
+            throw std::runtime_error { msg.str() };
+        }
+
+        // flat_locs[loc] is the node of the flat_tree at loc, a leaf being repeated
+        // down to the bottom slots of its subtree
+        std::size_t n_splits = (std::size_t { 1 } << m_depth) - 1;
+        std::vector<std::size_t> flat_locs(2 * n_splits + 1);
+        m_features.assign(n_splits, 0u);
+        m_thresholds.assign(n_splits, std::numeric_limits<double>::infinity());
+        for (std::size_t loc = 0; loc < n_splits; ++loc) {
+            std::size_t flat_loc = flat_locs[loc];
+            if (const auto* split = std::get_if<split_type>(&tree[flat_loc])) {
+                // m_n_features, one past the largest feature, is a std::uint32_t too
+                if (split->feature_id_ >= UINT32_MAX) {
+                    std::stringstream msg;
+                    msg << "Feature " << split->feature_id_
+                        << " is beyond the features a complete_tree can split on";
+                    throw std::runtime_error { msg.str() };
+                }
+                m_features[loc] = static_cast<std::uint32_t>(split->feature_id_);
+                m_thresholds[loc] = split->splitting.split;
+                m_n_features = std::max(m_n_features, m_features[loc] + 1);
+                flat_locs[2 * loc + 1] = tree.next(true, flat_loc);
+                flat_locs[2 * loc + 2] = tree.next(false, flat_loc);
+            } else {
+                flat_locs[2 * loc + 1] = flat_loc;
+                flat_locs[2 * loc + 2] = flat_loc;
+            }
+        }
+
+        std::vector<const leaf_t*> leaves;
+        std::vector<size_type> leaf_ids(tree.data().size(), UINT32_MAX);
+        for (std::size_t slot = 0; slot <= n_splits; ++slot) {
+            std::size_t flat_loc = flat_locs[n_splits + slot];
+            if (leaf_ids[flat_loc] == UINT32_MAX) {
+                leaf_ids[flat_loc] = static_cast<size_type>(leaves.size());
+                leaves.push_back(&std::get<leaf_t>(tree[flat_loc]));
+            }
+            m_leaves.push_back(leaf_ids[flat_loc]);
+        }
+
+        if constexpr (!std::is_same_v<leaf_t, binary_leaf>) {
+            for (const auto* leaf : leaves) {
+                auto size = static_cast<size_type>(leaf->value().size());
+                m_width = std::max(m_width, size);
+            }
+        }
+        m_values.resize(leaves.size() * m_width, 0.0);
+        for (std::size_t l = 0; l < leaves.size(); ++l) {
+            if constexpr (std::is_same_v<leaf_t, binary_leaf>)
+                m_values[l] = leaves[l]->probability();
+            else
+                std::ranges::copy(leaves[l]->value(), m_values.begin() + l * m_width);
+        }
+    }
+
+    bool operator==(const complete_tree&) const = default;
+
+    /// The number of splits from the root to every leaf.
+    std::size_t depth() const { return m_depth; }
+
+    /// The number of values in the row of a leaf.
+    size_type width() const { return m_width; }
+
+    const std::vector<std::uint32_t>& features() const { return m_features; }
+
+    const std::vector<double>& thresholds() const { return m_thresholds; }
+
+    /// The value of the leaf at a bottom slot.
+    value_type value(size_type slot) const
+    {
+        std::size_t row = m_leaves[slot];
+        if constexpr (std::is_same_v<leaf_t, binary_leaf>)
+            return m_values[row];
+        else
+            return { m_values.data() + row * m_width, m_width };
+    }
+
+    /// The bottom slot the sample reaches.
+    template <typename sample_t> size_type find_leaf(const sample_t& sample) const
+    {
+        std::size_t loc = 0;
+        for (std::size_t level = 0; level < m_depth; ++level) {
+            double x = sample[m_features[loc]];
+            loc = 2 * loc + 1 + !(x <= m_thresholds[loc]);
+        }
+        return static_cast<size_type>(loc - m_thresholds.size());
+    }
+
+    /// The value of the leaf the sample reaches.
+    template <typename sample_t> value_type apply(const sample_t& sample) const
+    {
+        return value(find_leaf(sample));
+    }
+
+    /// Writes the bottom slot each sample of the batch reaches.
+    void apply_batch(const dataset& batch, std::span<size_type> slots) const
+    {
+        check_batch(batch, slots.size());
+        // a single leaf reads no feature, so the batch may have no column to start
+        // the kernel from
+        if (m_depth == 0) {
+            std::ranges::fill(slots, size_type { 0u });
+            return;
+        }
+        if (slots.empty())
+            return;
+        find_complete_leaves(m_features.data(), m_thresholds.data(), m_depth,
+            batch.column(0).data(), batch.stride(), slots);
+    }
+
+    /// Writes the value of the leaf each sample of the batch reaches, a row of width()
+    /// values per sample, or one for a binary_leaf.
+    void apply_batch(const dataset& batch, std::span<double> out) const
+    {
+        std::size_t n = batch.number_of_samples();
+        if (out.size() != n * m_width) {
+            std::stringstream msg;
+            msg << "An output of " << out.size() << " values does not fit a batch of "
+                << n << " samples of " << m_width << " values";
+            throw std::runtime_error { msg.str() };
+        }
+
+        std::vector<size_type> slots(n);
+        apply_batch(batch, std::span { slots });
+        for (std::size_t i = 0; i < n; ++i) {
+            if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+                out[i] = value(slots[i]);
+            } else {
+                auto row = value(slots[i]);
+                for (std::size_t j = 0; j < m_width; ++j)
+                    out[i * m_width + j] = row[j];
+            }
+        }
+    }
+
+private:
+    static std::size_t depth_of(const flat_tree<split_type, leaf_t>& tree)
+    {
+        std::size_t depth = 0;
+        std::vector<std::size_t> locs { 0u };
+        while (!locs.empty()) {
+            std::size_t loc = locs.back();
+            locs.pop_back();
+            if (std::holds_alternative<split_type>(tree[loc])) {
+                locs.push_back(tree.next(true, loc));
+                locs.push_back(tree.next(false, loc));
+            } else {
+                depth = std::max(depth, tree.get_depth(loc));
+            }
+        }
+        return depth;
+    }
+
+    void check_batch(const dataset& batch, std::size_t n_samples) const
+    {
+        if (batch.number_of_samples() != n_samples) {
+            std::stringstream msg;
+            msg << "A batch of " << batch.number_of_samples()
+                << " samples does not fit an output of " << n_samples;
+            throw std::runtime_error { msg.str() };
+        }
+        if (n_samples != 0 && batch.size() < m_n_features) {
+            std::stringstream msg;
+            msg << "A batch of " << batch.size() << " features does not have feature "
+                << m_n_features - 1;
+            throw std::runtime_error { msg.str() };
+        }
+    }
+
+    std::size_t m_depth;
+
+    std::vector<std::uint32_t> m_features;
+
+    std::vector<double> m_thresholds;
+
+    std::vector<size_type> m_leaves;
+
+    std::vector<double> m_values;
+
+    size_type m_width;
+
+    // one past the largest feature of a split, what a batch must have
+    std::uint32_t m_n_features;
+};
+
+} // namespace dtree
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <array>
 #include <ranges>
 #include <tuple>
+#include <utility>
 #include <variant>
 
+#include "dtree/labels.h"
 #include "dtree/types.h"
 
 namespace dtree {
@@ -50,6 +53,9 @@ concept multi_numeric_sample_c = requires
 template <typename T>
 concept single_string_sample_c = std::convertible_to<T, std::string>;
 
+template <typename T>
+concept categorical_sample_c = std::same_as<T, category>;
+
 /// *_feature_c
 ///
 /// Basic feature types that hold training data of a single sample type
@@ -65,6 +71,10 @@ template <typename T>
 concept string_feature_c
     = std::ranges::sized_range<T> && single_string_sample_c<value_type<T>>;
 
+template <typename T>
+concept categorical_feature_c
+    = std::ranges::sized_range<T> && categorical_sample_c<value_type<T>>;
+
 /// *_feature_set_c
 ///
 /// The basic feature sets is a collection of features of the same type. All the feature
@@ -85,6 +95,10 @@ concept string_feature_set_c
     = string_feature_c<typename T::mapped_type> && std::is_convertible_v<feature_id,
         typename T::key_type>;
 
+template <typename T>
+concept categorical_feature_set_c = categorical_feature_c<
+    typename T::mapped_type> && std::is_convertible_v<feature_id, typename T::key_type>;
+
 /// mixed_feature_c
 /// mixed_feature_set_c
 ///
@@ -116,12 +130,68 @@ concept mixed_feature_set_c
     = mixed_feature_c<typename T::mapped_type> && std::convertible_to<feature_id,
         typename T::key_type>;
 
+/// labels_c
+///
+/// The labels of the samples being split. Algos should only need random access to the
+/// labels and their counts, so they can work on dtree::labels as well as views of a
+/// subset of them (see dtree::labels_view).
+template <typename T>
+concept labels_c = requires(const T& labels_, std::size_t loc)
+{
+    typename T::label_t;
+    { labels_.size() } -> std::convertible_to<std::size_t>;
+    { labels_[loc] } -> std::convertible_to<std::size_t>;
+    { labels_.number_of_labels() } -> std::convertible_to<std::size_t>;
+    { labels_.get_label_counts() } -> std::convertible_to<const label_counts&>;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////
 /// Algo concepts
 
 template <typename cost_fn_t>
 concept cost_fn_c = std::is_invocable_r_v<double, cost_fn_t, const label_counts&>;
 
+/// incremental_cost_fn_c
+///
+/// A cost function that can also follow the cost of a set of label counts as samples
+/// are added to and removed from it. accumulate(counts) starts an accumulator at the
+/// counts and each add or remove is O(1) rather than the O(labels) of a call, which
+/// makes a scan over the candidate splits of a node linear (see algos::split_scan).
+template <typename cost_fn_t>
+concept incremental_cost_fn_c = cost_fn_c<cost_fn_t> && requires(
+    const cost_fn_t& cost_fn, const label_counts& counts, std::size_t label)
+{
+    { cost_fn.accumulate(counts) };
+    requires requires(decltype(cost_fn.accumulate(counts)) accumulator)
+    {
+        accumulator.add(label, label);
+        accumulator.remove(label, label);
+        { std::as_const(accumulator).cost() } -> std::convertible_to<double>;
+    };
+};
+
+/// fixed_cost_fn_c
+///
+/// A cost function that can also take the counts of a fixed number of labels as a
+/// std::array, as counted by the algos specialised to a number of classes. With two
+/// classes gini_impurity and entropy_impurity have closed forms.
+template <typename cost_fn_t, std::size_t n_classes>
+concept fixed_cost_fn_c = std::is_invocable_r_v<double, cost_fn_t,
+    const std::array<std::size_t, n_classes>&>;
+
+/// presorted_algo_c
+///
+/// An algo that can find a split from samples already ordered by value, passed as a
+/// random access range of (value, label) pairs along with their label counts. This
+/// lets the tree builder sort each feature once rather than at every node.
+template <typename algo_t, typename cost_fn_t>
+concept presorted_algo_c = requires(const algo_t& algo,
+    const std::vector<std::pair<double, labels::label_t>>& data,
+    const label_counts& counts, cost_fn_t cost_fn)
+{
+    algo.split_sorted(data, counts, cost_fn);
+};
+
 template <typename splitting_t, typename feature_t>
 inline constexpr bool splits_v
     = std::is_invocable_r_v<bool, splitting_t, const feature_t&>;
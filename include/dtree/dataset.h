@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "dtree/concepts.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// aligned_allocator
+///
+/// Allocates blocks aligned to the given number of bytes, e.g. to cache lines so a
+/// column never shares a line with its neighbour.
+template <typename T, std::size_t alignment> struct aligned_allocator {
+    using value_type = T;
+
+    template <typename U> struct rebind {
+        using other = aligned_allocator<U, alignment>;
+    };
+
+    aligned_allocator() = default;
+
+    template <typename U> aligned_allocator(const aligned_allocator<U, alignment>&) { }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t { alignment }));
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        ::operator delete(p, std::align_val_t { alignment });
+    }
+
+    template <typename U>
+    bool operator==(const aligned_allocator<U, alignment>&) const
+    {
+        return true;
+    }
+};
+
+/// basic_dataset
+///
+/// A column store of single numeric features with the dense ids 0, ..., n - 1. All the
+/// columns live in one block, each starting on a cache line. It reads like the
+/// unordered_map feature sets, each feature being a span over its column, so it
+/// satisfies single_numeric_feature_set_c and can be passed to anything taking one,
+/// but looking up a feature is an index rather than a hash. The tree builder copies the
+/// samples of each node into a contiguous dataset of their own with select, or when
+/// tree_builder_config::in_place is set partitions a buffer of sample indices instead.
+///
+/// Storing the values as float halves the memory traffic of a split search, the
+/// thresholds of the splittings are still doubles.
+template <single_numeric_sample_c value_t> class basic_dataset {
+public:
+    using key_type = feature_id;
+    using mapped_type = std::span<const value_t>;
+    using value_type = std::pair<const feature_id, mapped_type>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+    using iterator = const_iterator;
+
+    static constexpr std::size_t alignment = 64;
+
+    basic_dataset()
+        : basic_dataset { 0u, 0u }
+    {
+    }
+
+    /// A dataset of zeros to be filled through column.
+    basic_dataset(std::size_t n_features, std::size_t n_samples)
+        : m_n_samples { n_samples }
+        , m_stride { padded_size(n_samples) }
+        , m_data(n_features * m_stride, value_t {})
+        , m_columns {}
+    {
+        make_columns(n_features);
+    }
+
+    /// Copies a feature set whose ids are 0, ..., n - 1.
+    template <single_numeric_feature_set_c feature_set>
+    explicit basic_dataset(const feature_set& features)
+        : basic_dataset { features.size(), number_of_samples(features) }
+    {
+        for (const auto& [feature_id, feature] : features) {
+            if (feature_id >= size() || feature.size() != m_n_samples) {
+                std::stringstream msg;
+                msg << "Feature " << feature_id << " with " << feature.size()
+                    << " samples does not fit a dataset of " << size()
+                    << " features of " << m_n_samples << " samples";
+                throw std::runtime_error { msg.str() };
+            }
+
+            auto out = column(feature_id);
+            std::size_t i = 0;
+            for (const auto& x : feature)
+                out[i++] = static_cast<value_t>(x);
+        }
+    }
+
+    basic_dataset(const basic_dataset& other)
+        : m_n_samples { other.m_n_samples }
+        , m_stride { other.m_stride }
+        , m_data { other.m_data }
+        , m_columns {}
+    {
+        make_columns(other.size());
+    }
+
+    basic_dataset(basic_dataset&&) = default;
+
+    basic_dataset& operator=(const basic_dataset& other)
+    {
+        if (this != &other) {
+            m_n_samples = other.m_n_samples;
+            m_stride = other.m_stride;
+            m_data = other.m_data;
+            make_columns(other.size());
+        }
+        return *this;
+    }
+
+    basic_dataset& operator=(basic_dataset&&) = default;
+
+    const_iterator begin() const { return m_columns.begin(); }
+    const_iterator end() const { return m_columns.end(); }
+
+    const_iterator find(feature_id id) const
+    {
+        return id < size() ? begin() + id : end();
+    }
+
+    bool contains(feature_id id) const { return id < size(); }
+
+    const mapped_type& at(feature_id id) const
+    {
+        if (!contains(id)) {
+            std::stringstream msg;
+            msg << "No feature " << id << " in a dataset of " << size() << " features";
+            throw std::out_of_range { msg.str() };
+        }
+        return m_columns[id].second;
+    }
+
+    /// The number of features.
+    std::size_t size() const { return m_columns.size(); }
+
+    std::size_t number_of_samples() const { return m_n_samples; }
+
+    /// The distance between the starts of consecutive columns, so sample i of feature f
+    /// is at column(0).data()[f * stride() + i].
+    std::size_t stride() const { return m_stride; }
+
+    std::span<value_t> column(feature_id id)
+    {
+        return { m_data.data() + id * m_stride, m_n_samples };
+    }
+
+    std::span<const value_t> column(feature_id id) const
+    {
+        return { m_data.data() + id * m_stride, m_n_samples };
+    }
+
+    /// The samples at the given locations, as a dataset of their own.
+    basic_dataset select(std::span<const std::size_t> index) const
+    {
+        basic_dataset out { size(), index.size() };
+        for (feature_id id = 0; id < size(); ++id) {
+            auto in = column(id);
+            auto selected = out.column(id);
+            for (std::size_t i = 0; i < index.size(); ++i)
+                selected[i] = in[index[i]];
+        }
+        return out;
+    }
+
+private:
+    static std::size_t padded_size(std::size_t n_samples)
+    {
+        constexpr std::size_t per_line = alignment / sizeof(value_t);
+        return (n_samples + per_line - 1) / per_line * per_line;
+    }
+
+    template <typename feature_set>
+    static std::size_t number_of_samples(const feature_set& features)
+    {
+        return features.size() == 0 ? 0u : std::begin(features)->second.size();
+    }
+
+    void make_columns(std::size_t n_features)
+    {
+        m_columns.clear();
+        m_columns.reserve(n_features);
+        for (feature_id id = 0; id < n_features; ++id) {
+            m_columns.emplace_back(id, std::as_const(*this).column(id));
+        }
+    }
+
+    std::size_t m_n_samples;
+
+    std::size_t m_stride;
+
+    std::vector<value_t, aligned_allocator<value_t, alignment>> m_data;
+
+    std::vector<value_type> m_columns;
+};
+
+using dataset = basic_dataset<double>;
+
+using float_dataset = basic_dataset<float>;
+
+template <typename T> struct is_dataset {
+    static constexpr bool value() { return false; }
+};
+
+template <typename value_t> struct is_dataset<basic_dataset<value_t>> {
+    static constexpr bool value() { return true; }
+};
+
+template <typename T>
+concept dataset_c = is_dataset<T>::value();
+
+} // namespace dtree
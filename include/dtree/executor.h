@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dtree {
+
+/// executor
+///
+/// Runs the sub trees of a node, and the split search over its features, in parallel
+/// for the tree builder (see tree_builder_config::executor_). The only primitive is a
+/// fork join of two tasks, which may themselves fork, so executors must not block a
+/// thread waiting for a task that has not started.
+class executor {
+public:
+    virtual ~executor() = default;
+
+    /// Runs both tasks, possibly concurrently, and returns once both have finished.
+    /// If either throws the exception is rethrown here.
+    virtual void invoke(
+        const std::function<void()>& lower, const std::function<void()>& upper)
+        = 0;
+
+    /// The number of tasks that can run at once.
+    virtual std::size_t concurrency() const = 0;
+
+    /// Runs fn(i) for every i in [0, n), possibly concurrently, by recursively halving
+    /// the range with invoke.
+    void parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn);
+
+private:
+    void parallel_for(
+        std::size_t first, std::size_t last, const std::function<void(std::size_t)>& fn);
+};
+
+/// work_stealing_pool
+///
+/// A fixed number of worker threads each with its own deque of tasks. invoke pushes the
+/// second task onto the back of the calling worker's deque and runs the first inline.
+/// Idle workers steal from the front of other deques, i.e. the oldest and so largest
+/// sub trees. If the second task was not stolen it is popped and run inline, otherwise
+/// the caller runs other tasks until it completes, so no thread ever blocks and the
+/// number of threads stays at the pool size however deep the recursion goes. Threads
+/// outside the pool share one extra deque.
+class work_stealing_pool : public executor {
+public:
+    explicit work_stealing_pool(
+        std::size_t n_threads = std::thread::hardware_concurrency());
+
+    ~work_stealing_pool() override;
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    void invoke(const std::function<void()>& lower,
+        const std::function<void()>& upper) override;
+
+    std::size_t concurrency() const override { return m_threads.size(); }
+
+private:
+    struct task;
+
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<task*> tasks;
+    };
+
+    std::size_t queue_index() const;
+
+    void push(std::size_t index, task* t);
+
+    bool reclaim(std::size_t index, task* t);
+
+    task* pop(std::size_t index);
+
+    task* steal(std::size_t index);
+
+    bool run_one(std::size_t index);
+
+    void run_worker(std::size_t index);
+
+    std::vector<std::unique_ptr<task_queue>> m_queues;
+
+    std::atomic<std::size_t> m_pending;
+
+    std::atomic<bool> m_stop;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_wake;
+
+    std::vector<std::thread> m_threads;
+};
+
+} // namespace dtree
@@ -1,6 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 #include "dtree/labels.h"
 #include "dtree/splittings.h"
@@ -10,6 +19,8 @@ namespace dtree {
 
 class leaf {
 public:
+    using value_type = label_distribution;
+
     // TODO - remove this perhaps
     leaf()
         : m_label_distribution {}
@@ -25,10 +36,59 @@ public:
 
     const label_distribution& distribution() const { return m_label_distribution; }
 
+    const value_type& value() const { return m_label_distribution; }
+
 private:
     label_distribution m_label_distribution;
 };
 
+/// binary_leaf
+///
+/// The leaf of a two class tree, which only needs the probability of label 1 rather
+/// than a distribution on the heap.
+class binary_leaf {
+public:
+    using value_type = double;
+
+    binary_leaf()
+        : m_probability { 0.0 }
+    {
+    }
+
+    explicit binary_leaf(double probability)
+        : m_probability { probability }
+    {
+    }
+
+    bool operator==(const binary_leaf&) const = default;
+
+    double probability() const { return m_probability; }
+
+    label_distribution distribution() const
+    {
+        return { 1.0 - m_probability, m_probability };
+    }
+
+    const value_type& value() const { return m_probability; }
+
+private:
+    double m_probability;
+};
+
+/// The leaf holding the given label counts.
+template <typename leaf_t> leaf_t make_leaf(const label_counts& counts)
+{
+    if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+        std::size_t total = 0u;
+        for (std::size_t c : counts)
+            total += c;
+        double ones = counts.size() > 1 ? counts[1] : 0u;
+        return binary_leaf { total == 0 ? 0.0 : ones / total };
+    } else {
+        return leaf { calculate_distribution(counts) };
+    }
+}
+
 /// flat_tree
 ///
 /// The simplest type of tree we have. It is quite wasteful if the tree completes at
@@ -36,12 +96,14 @@ private:
 /// $2^(n+1) - 1$ nodes and this model stores them as a contiguous block. This does make
 /// searching through the tree quite simple as we know where the next nodes are -
 /// specifically if a node is at location $i$ then its children are at $i << 1 + {1|2}$.
-template <typename split_t> class flat_tree {
+template <typename split_t, typename leaf_t> class flat_tree {
     // TODO - do we want to make sure split_t = node<split_t>??
     //      - or do we wrap in a node here?
-    using node_t = std::variant<split_t, leaf>;
+    using node_t = std::variant<split_t, leaf_t>;
 
 public:
+    using leaf_type = leaf_t;
+
     using container_t = std::vector<node_t>;
     using value_type = container_t::value_type;
     using reference = container_t::reference;
@@ -78,13 +140,15 @@ public:
 
     const container_t& data() const { return m_container; }
 
+    /// The value of the leaf the sample reaches, the distribution of the labels or for
+    /// a binary_leaf the probability of label 1.
     template <typename sample_t>
-    const label_distribution& apply(const sample_t& sample) const
+    const typename leaf_t::value_type& apply(const sample_t& sample) const
     {
         for (size_type loc = 0;;) {
             const auto& node = m_container[loc];
-            if (std::holds_alternative<leaf>(node)) {
-                return std::get<leaf>(node).distribution();
+            if (std::holds_alternative<leaf_t>(node)) {
+                return std::get<leaf_t>(node).value();
             }
 
             const auto& split = std::get<split_t>(node);
@@ -92,7 +156,191 @@ public:
         }
     }
 
+    /// Applies the tree to a batch of samples held as columns, a feature set mapping
+    /// each feature id the tree splits on to a feature of the same number of samples
+    /// (e.g. a dtree::dataset), writing the location of the leaf each sample reaches.
+    /// The reachable nodes are first listed breadth first, each split pointing at its
+    /// splitting and holding the column of its feature, so the batch descends a dense
+    /// array of nodes and reads its features without looking them up. Rather than
+    /// each sample walking down alone, a chain of dependent loads and mispredicted
+    /// branches, every split partitions the samples reaching it between its children
+    /// in one pass without a branch on the comparison.
+    /// Throws before writing anything if the batch lacks a feature the tree splits on.
+    template <typename feature_set>
+    void apply_batch(const feature_set& features, std::span<size_type> leaves) const
+    {
+        auto nodes = list_batch_nodes(features, leaves.size());
+        descend_batch(nodes, leaves.size(),
+            [&](size_type loc, std::span<const size_type> samples) {
+                for (size_type i : samples)
+                    leaves[i] = loc;
+            });
+    }
+
+    /// Applies the tree to a batch of samples as above, writing the value of the leaf
+    /// each sample reaches. For a binary_leaf that is the probability of label 1 and
+    /// out holds one per sample, otherwise out holds a row of probabilities per sample,
+    /// its width being the number of labels, and a distribution over fewer labels is
+    /// padded with zeros.
+    template <typename feature_set>
+    void apply_batch(const feature_set& features, std::span<double> out) const
+    {
+        std::size_t n = number_of_samples(features);
+        std::size_t width = n == 0 ? 1u : out.size() / n;
+        if (width == 0 || width * n != out.size()
+            || (std::is_same_v<leaf_t, binary_leaf> && width != 1)) {
+            std::stringstream msg;
+            msg << "An output of " << out.size() << " values does not fit a batch of "
+                << n << " samples";
+            throw std::runtime_error { msg.str() };
+        }
+
+        auto nodes = list_batch_nodes(features, n);
+        descend_batch(nodes, n, [&](size_type loc, std::span<const size_type> samples) {
+            const auto& value = std::get_if<leaf_t>(&m_container[loc])->value();
+            if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+                for (size_type i : samples)
+                    out[i] = value;
+            } else {
+                // rows are a few labels wide, too short for a call to memcpy
+                std::size_t n_values = std::min(value.size(), width);
+                for (size_type i : samples) {
+                    double* row = out.data() + i * width;
+                    for (std::size_t j = 0; j < n_values; ++j)
+                        row[j] = value[j];
+                    for (std::size_t j = n_values; j < width; ++j)
+                        row[j] = 0.0;
+                }
+            }
+        });
+    }
+
 private:
+    // samples partitioned down the tree at a time, so their indices and the features
+    // they read stay in cache
+    static constexpr size_type batch_chunk_size = 4096;
+
+    /// A column of a batch, a pointer to the first sample of a contiguous feature so
+    /// reading a sample is a single load, otherwise a pointer to the feature.
+    template <typename feature_t>
+    using column_t = std::conditional_t<std::ranges::contiguous_range<feature_t>,
+        const std::ranges::range_value_t<feature_t>*, const feature_t*>;
+
+    template <typename feature_set>
+    static std::size_t number_of_samples(const feature_set& features)
+    {
+        return std::begin(features) == std::end(features)
+            ? 0u
+            : std::ranges::size(std::begin(features)->second);
+    }
+
+    template <typename feature_t>
+    static decltype(auto) sample_at(column_t<feature_t> column, size_type i)
+    {
+        if constexpr (std::ranges::contiguous_range<feature_t>)
+            return column[i];
+        else
+            return (*column)[i];
+    }
+
+    /// A reachable node of the tree as a batch descends it. A split points at its
+    /// splitting and holds the column of its feature and the index of its lower child,
+    /// the upper child following it, and a leaf holds a null column and its location
+    /// in the tree.
+    template <typename feature_t> struct batch_node {
+        const split_t* split;
+        column_t<feature_t> column;
+        size_type next;
+    };
+
+    /// The reachable nodes of the tree breadth first, each split holding the column of
+    /// its feature in the batch, found with the find of the feature set. Throws if the
+    /// batch is missing a feature the tree splits on or its features differ in size.
+    template <typename feature_set>
+    auto list_batch_nodes(const feature_set& features, std::size_t n_samples) const
+    {
+        using feature_t = feature_set::mapped_type;
+        for (const auto& [feature_id, feature] : features) {
+            if (std::ranges::size(feature) != n_samples) {
+                std::stringstream msg;
+                msg << "Feature " << feature_id << " has " << std::ranges::size(feature)
+                    << " samples in a batch of " << n_samples;
+                throw std::runtime_error { msg.str() };
+            }
+        }
+
+        // a node is listed holding its location, which a split swaps for the index of
+        // its children once they are listed
+        std::vector<batch_node<feature_t>> nodes { { nullptr, nullptr, 0u } };
+        for (size_type k = 0; k < nodes.size(); ++k) {
+            size_type loc = nodes[k].next;
+            const auto* split = std::get_if<split_t>(&m_container[loc]);
+            if (split == nullptr)
+                continue;
+
+            auto feature = features.find(split->feature_id_);
+            if (feature == std::end(features)) {
+                std::stringstream msg;
+                msg << "A batch without feature " << split->feature_id_
+                    << " does not fit a tree splitting on it";
+                throw std::runtime_error { msg.str() };
+            }
+            if constexpr (std::ranges::contiguous_range<feature_t>)
+                nodes[k] = { split, std::ranges::data(feature->second), nodes.size() };
+            else
+                nodes[k] = { split, &feature->second, nodes.size() };
+            nodes.push_back({ nullptr, nullptr, next(true, loc) });
+            nodes.push_back({ nullptr, nullptr, next(false, loc) });
+        }
+        return nodes;
+    }
+
+    /// Sends the samples 0, ..., n_samples - 1 down the tree a chunk at a time, calling
+    /// visit_leaf with the location of each leaf reached and the samples reaching it.
+    /// As in the tree_builder, a split stably partitions the indices of its samples
+    /// into those of its two children, in place but for the upper ones going through a
+    /// buffer, and the nodes being listed breadth first the samples of a node are
+    /// known by the time it is reached.
+    template <typename feature_t, typename visitor_t>
+    static void descend_batch(const std::vector<batch_node<feature_t>>& nodes,
+        std::size_t n_samples, visitor_t&& visit_leaf)
+    {
+        std::vector<size_type> index(std::min(n_samples, batch_chunk_size));
+        std::vector<size_type> upper(index.size());
+        // the samples of node k are index[first], ..., index[last - 1]
+        std::vector<std::pair<size_type, size_type>> ranges(nodes.size());
+        for (size_type offset = 0; offset < n_samples; offset += index.size()) {
+            size_type n_chunk = std::min(index.size(), n_samples - offset);
+            for (size_type j = 0; j < n_chunk; ++j)
+                index[j] = offset + j;
+            ranges[0] = { 0u, n_chunk };
+
+            for (size_type k = 0; k < nodes.size(); ++k) {
+                const auto& node = nodes[k];
+                auto [first, last] = ranges[k];
+                if (node.column == nullptr) {
+                    if (first != last)
+                        visit_leaf(node.next, { index.data() + first, last - first });
+                    continue;
+                }
+
+                size_type n_lower = first;
+                size_type n_upper = 0;
+                for (size_type j = first; j < last; ++j) {
+                    size_type i = index[j];
+                    bool lower = node.split->splitting(sample_at<feature_t>(node.column, i));
+                    index[n_lower] = i;
+                    upper[n_upper] = i;
+                    n_lower += lower;
+                    n_upper += !lower;
+                }
+                std::copy_n(upper.data(), n_upper, index.data() + n_lower);
+                ranges[node.next] = { first, n_lower };
+                ranges[node.next + 1] = { n_lower, last };
+            }
+        }
+    }
+
     container_t m_container;
 };
 
@@ -1,11 +1,167 @@
 #pragma once
 
+#include <array>
+#include <cmath>
+#include <span>
+
 #include "dtree/labels.h"
 
 namespace dtree {
 
+/// c log2(c), taken to be 0 at c = 0. The small counts are read from a table.
+double c_log2_c(std::size_t c);
+
+/// The gini index of the counts, 0 when there are none. The sum of the squares is
+/// vectorised for the widest instruction set the cpu supports.
 double gini_index(const label_counts&);
 
+/// The entropy of the counts in bits, 0 when there are none, as (n log2(n) - s) / n
+/// with s the sum of c log2(c). As with gini_index the sum is vectorised, gathering
+/// the small counts from a table.
 double entropy(const label_counts&);
 
+/// The sums over the counts that the impurity measures are computed from: the total
+/// and either the sum of the squares or of c log2(c). The sum of c log2(c) carries the
+/// rounding error of its terms and additions as a compensation, sum + compensation
+/// being close to twice double precision, so entropy loses nothing to cancellation.
+struct count_sums {
+    std::size_t total;
+    double sum;
+    double compensation = 0.0;
+};
+
+/// impurity_kernels
+///
+/// An implementation of the sums behind gini_index and entropy for one instruction
+/// set.
+struct impurity_kernels {
+    const char* name;
+    count_sums (*sum_squares)(const std::size_t* counts, std::size_t n);
+    count_sums (*sum_c_log2_c)(const std::size_t* counts, std::size_t n);
+};
+
+/// The kernels the cpu running the process supports, widest first, ending with the
+/// scalar ones. gini_index and entropy use the first.
+std::span<const impurity_kernels> supported_impurity_kernels();
+
+/// The gini index of two classes, 2ab / n^2.
+inline double binary_gini_index(std::size_t a, std::size_t b)
+{
+    double total = a + b;
+    return total == 0.0 ? 0.0 : 2.0 * a * b / (total * total);
+}
+
+/// The entropy of two classes, log2(n) - (a log2(a) + b log2(b)) / n.
+inline double binary_entropy(std::size_t a, std::size_t b)
+{
+    double total = a + b;
+    return total == 0.0 ? 0.0 : std::log2(total) - (c_log2_c(a) + c_log2_c(b)) / total;
+}
+
+/// gini_impurity
+///
+/// gini_index as a function object that is also an incremental_cost_fn_c. Its
+/// accumulator keeps the sum of the squared counts, which changes by 2c + 1 when a
+/// sample is added to a label with count c, so the cost is 1 - sum / n^2 without
+/// visiting the other labels.
+struct gini_impurity {
+    class accumulator {
+    public:
+        explicit accumulator(label_counts counts);
+
+        void add(std::size_t label, std::size_t count = 1)
+        {
+            std::size_t& c = m_counts[label];
+            m_sum_squares += count * (2 * c + count);
+            c += count;
+            m_total += count;
+        }
+
+        void remove(std::size_t label, std::size_t count = 1)
+        {
+            std::size_t& c = m_counts[label];
+            m_sum_squares -= count * (2 * c - count);
+            c -= count;
+            m_total -= count;
+        }
+
+        double cost() const
+        {
+            if (m_total == 0)
+                return 0.0;
+            double total = m_total;
+            return 1.0 - static_cast<double>(m_sum_squares) / (total * total);
+        }
+
+    private:
+        label_counts m_counts;
+
+        std::size_t m_total;
+
+        std::size_t m_sum_squares;
+    };
+
+    double operator()(const label_counts& counts) const { return gini_index(counts); }
+
+    double operator()(const std::array<std::size_t, 2>& counts) const
+    {
+        return binary_gini_index(counts[0], counts[1]);
+    }
+
+    accumulator accumulate(label_counts counts) const
+    {
+        return accumulator { std::move(counts) };
+    }
+};
+
+/// entropy_impurity
+///
+/// entropy as a function object that is also an incremental_cost_fn_c. With n samples
+/// and s the sum of c log2(c) over the counts the entropy is (n log2(n) - s) / n, and
+/// the accumulator updates s for the one count that changes. It keeps s compensated
+/// and takes n log2(n) to the same precision as entropy does, so however long a scan
+/// the cost is that of entropy on the counts.
+struct entropy_impurity {
+    class accumulator {
+    public:
+        explicit accumulator(label_counts counts);
+
+        void add(std::size_t label, std::size_t count = 1)
+        {
+            std::size_t& c = m_counts[label];
+            set_count(c, c + count);
+            m_sums.total += count;
+        }
+
+        void remove(std::size_t label, std::size_t count = 1)
+        {
+            std::size_t& c = m_counts[label];
+            set_count(c, c - count);
+            m_sums.total -= count;
+        }
+
+        double cost() const;
+
+    private:
+        /// Sets count to c, swapping its term of the sum for that of c.
+        void set_count(std::size_t& count, std::size_t c);
+
+        label_counts m_counts;
+
+        count_sums m_sums;
+    };
+
+    double operator()(const label_counts& counts) const { return entropy(counts); }
+
+    double operator()(const std::array<std::size_t, 2>& counts) const
+    {
+        return binary_entropy(counts[0], counts[1]);
+    }
+
+    accumulator accumulate(label_counts counts) const
+    {
+        return accumulator { std::move(counts) };
+    }
+};
+
 } // namespace dtree
@@ -1,20 +1,51 @@
 #pragma once
 
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
 #include "dtree/types.h"
 
 namespace dtree {
 
+/// Normalises the counts into a distribution over the labels.
+label_distribution calculate_distribution(const label_counts&);
+
+/// The counts of the labels, sized up to the largest of them.
+template <typename range_t> label_counts count_labels(const range_t& labels_)
+{
+    label_counts out;
+
+    for (std::size_t label : labels_) {
+        if (label >= out.size()) {
+            out.resize(label + 1, 0u);
+        }
+
+        out[label]++;
+    }
+
+    return out;
+}
+
 // FIXME - do we want a labels type or do we want a
 //         to just have methods around the labels?
-class labels {
+/// basic_labels
+///
+/// The labels of the training samples, stored as label_type. The split searches stream
+/// the labels of a node, so the narrowest type holding every label keeps the most of
+/// them in cache: std::uint8_t holds up to 256 classes. The counts are always
+/// label_counts, whatever the width of the labels.
+template <std::unsigned_integral label_type> class basic_labels {
 public:
-    using label_t = std::size_t; // FIXME - make more compact
+    using label_t = label_type;
 
     using value_type = label_t;
     using reference = value_type; // FIXME
 
     template <typename... Args>
-    explicit labels(Args&&... args)
+    explicit basic_labels(Args&&... args)
         : m_data { std::forward<Args>(args)... }
         , m_label_counts { count_labels(m_data) }
     {
@@ -33,14 +64,7 @@ public:
 
     label_distribution calculate_distribution() const
     {
-        label_distribution out(m_label_counts.size(), 0.0);
-        double total_count = m_data.size();
-
-        for (std::size_t i = 0; i < m_label_counts.size(); ++i) {
-            out[i] = static_cast<double>(m_label_counts[i]) / total_count;
-        }
-
-        return out;
+        return dtree::calculate_distribution(m_label_counts);
     }
 
     void push_back(label_t label)
@@ -57,11 +81,70 @@ public:
     std::size_t size() const { return m_data.size(); }
 
 private:
-    static label_counts count_labels(const std::vector<label_t>&);
-
     std::vector<label_t> m_data;
 
     label_counts m_label_counts;
 };
 
+using labels = basic_labels<std::uint32_t>;
+
+/// The counts of the labels at the given locations, sized up to the largest of them as
+/// with basic_labels::get_label_counts.
+template <typename label_t>
+label_counts count_labels(
+    const basic_labels<label_t>& labels_, std::span<const std::size_t> index)
+{
+    label_counts out;
+
+    for (std::size_t i : index) {
+        std::size_t label = labels_[i];
+        if (label >= out.size()) {
+            out.resize(label + 1, 0u);
+        }
+
+        out[label]++;
+    }
+
+    return out;
+}
+
+/// labels_view
+///
+/// The labels of a subset of the samples, given by their locations in a labels object.
+/// It reads like labels but only the label counts are computed, nothing is copied.
+template <typename labels_t> class labels_view {
+public:
+    using label_t = labels_t::label_t;
+
+    using value_type = label_t;
+    using reference = value_type;
+
+    labels_view(const labels_t& labels_, std::span<const std::size_t> index)
+        : m_labels { &labels_ }
+        , m_index { index }
+        , m_label_counts { count_labels(labels_, index) }
+    {
+    }
+
+    label_t operator[](std::size_t loc) const { return (*m_labels)[m_index[loc]]; }
+
+    std::size_t number_of_labels() const { return m_label_counts.size(); }
+
+    const label_counts& get_label_counts() const { return m_label_counts; }
+
+    label_distribution calculate_distribution() const
+    {
+        return dtree::calculate_distribution(m_label_counts);
+    }
+
+    std::size_t size() const { return m_index.size(); }
+
+private:
+    const labels_t* m_labels;
+
+    std::span<const std::size_t> m_index;
+
+    label_counts m_label_counts;
+};
+
 } // namespace dtree
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "dtree/binning.h"
+#include "dtree/flat_tree.h"
+#include "dtree/labels.h"
+#include "dtree/tree_builder.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// level_wise_tree_builder
+///
+/// Builds the same trees as tree_builder from binned features, but breadth first. The
+/// open nodes of a depth are a contiguous range of flat_tree slots and are all split
+/// together: each feature column is swept once per depth, adding every sample to the
+/// label histogram of its node, so the samples are streamed in order rather than
+/// gathered node by node. Between depths only the node of each sample changes, the
+/// features and labels are never copied or reordered.
+///
+/// Uses the stopping conditions of the config and, with parallel_features, sweeps
+/// chunks of the features in parallel on the executor. The histograms of a feature
+/// are capped at max_histogram_counts counts, so deep levels with many open nodes
+/// sweep each feature once per batch of nodes rather than all at once.
+template <typename algo_t, typename cost_fn_t>
+    requires histogram_algo_c<algo_t, const cost_fn_t&>
+class level_wise_tree_builder {
+public:
+    using node_type = node<typename algo_t::splitting_type>;
+    using tree_t = flat_tree_t<algo_t>;
+    using leaf_t = tree_t::leaf_type;
+
+    level_wise_tree_builder(const tree_builder_config& config)
+        : m_config { config }
+        , m_algo {}
+        , m_cost_fn {}
+    {
+    }
+
+    level_wise_tree_builder(
+        const tree_builder_config& config, algo_t algo, cost_fn_t cost_fn)
+        : m_config { config }
+        , m_algo { std::move(algo) }
+        , m_cost_fn { std::move(cost_fn) }
+    {
+    }
+
+    template <binned_feature_set_c feature_set, typename label_t>
+    tree_t build(const feature_set& features, const basic_labels<label_t>& labels_) const
+    {
+        check_number_of_labels<algo_t>(labels_.number_of_labels());
+        tree_t tree { m_config.max_depth };
+
+        // with nothing to split on the root is a leaf
+        if (features.size() == 0u) {
+            tree[0] = make_leaf<leaf_t>(labels_.get_label_counts());
+            return tree;
+        }
+
+        feature_list_t feature_list;
+        feature_list.reserve(features.size());
+        for (const auto& [feature_id, feature] : features) {
+            feature_list.emplace_back(feature_id, &feature);
+        }
+
+        // the open node of each sample, as an index into locs, or closed once the
+        // sample has reached a leaf
+        std::vector<std::size_t> sample_nodes(labels_.size(), 0u);
+        std::vector<std::size_t> locs { 0u };
+
+        while (!locs.empty()) {
+            auto split_locs = close_leaves(tree, labels_, locs, sample_nodes);
+            if (split_locs.empty())
+                break;
+
+            auto splits
+                = find_splits(feature_list, labels_, sample_nodes, split_locs.size());
+            locs = split_nodes(tree, features, splits, split_locs, sample_nodes);
+        }
+
+        return tree;
+    }
+
+private:
+    static constexpr std::size_t closed = std::numeric_limits<std::size_t>::max();
+
+    using feature_list_t = std::vector<std::pair<feature_id, const binned_feature*>>;
+
+    using split_candidate = std::pair<double, node_type>;
+
+    /// Makes leaves of the open nodes that should stop and renumbers the samples of the
+    /// others, returning the locations of the nodes left to split.
+    template <typename labels_t>
+    std::vector<std::size_t> close_leaves(tree_t& tree, const labels_t& labels_,
+        const std::vector<std::size_t>& locs,
+        std::vector<std::size_t>& sample_nodes) const
+    {
+        std::vector<label_counts> counts(
+            locs.size(), label_counts(labels_.number_of_labels(), 0u));
+        for (std::size_t i = 0; i < sample_nodes.size(); ++i) {
+            if (sample_nodes[i] != closed)
+                counts[sample_nodes[i]][labels_[i]]++;
+        }
+
+        std::vector<std::size_t> renumbered(locs.size(), closed);
+        std::vector<std::size_t> split_locs;
+        for (std::size_t node = 0; node < locs.size(); ++node) {
+            // sized up to the largest label present, as with labels::get_label_counts
+            auto& node_counts = counts[node];
+            auto last = std::find_if(rbegin(node_counts), rend(node_counts),
+                [](std::size_t count) { return count != 0u; });
+            node_counts.erase(last.base(), end(node_counts));
+
+            std::size_t depth = tree_t::get_depth(locs[node]);
+            std::size_t n_samples = std::accumulate(
+                begin(node_counts), end(node_counts), std::size_t { 0 });
+            if (auto reason = should_stop(m_config, depth, node_counts, n_samples)) {
+                SPDLOG_DEBUG("Stopping building at depth {} as {}", depth, reason);
+                tree[locs[node]] = make_leaf<leaf_t>(node_counts);
+            } else {
+                renumbered[node] = split_locs.size();
+                split_locs.push_back(locs[node]);
+            }
+        }
+
+        for (auto& node : sample_nodes) {
+            if (node != closed)
+                node = renumbered[node];
+        }
+
+        return split_locs;
+    }
+
+    /// The best split of each of the n_nodes open nodes. Every feature is swept to build
+    /// the histograms of the nodes, which the algo then splits. The nodes are taken in
+    /// batches whose histograms fit in max_histogram_counts, and the histograms of a
+    /// batch are reused from one feature to the next.
+    template <typename labels_t>
+    std::vector<split_candidate> find_splits(const feature_list_t& feature_list,
+        const labels_t& labels_, const std::vector<std::size_t>& sample_nodes,
+        std::size_t n_nodes) const
+    {
+        auto find_best = [this, &feature_list, &labels_, &sample_nodes, n_nodes](
+                             std::size_t first, std::size_t last) {
+            std::vector<split_candidate> best(n_nodes,
+                { std::numeric_limits<double>::max(),
+                    { std::numeric_limits<feature_id>::max(), {} } });
+
+            std::size_t n_labels = labels_.number_of_labels();
+            std::vector<label_histogram> histograms;
+
+            for (std::size_t k = first; k < last; ++k) {
+                const auto& [feature_id, feature] = feature_list[k];
+                std::size_t n_bins = feature->number_of_bins();
+                std::size_t node_counts = std::max<std::size_t>(n_bins * n_labels, 1u);
+                std::size_t batch_size = std::max<std::size_t>(
+                    m_config.max_histogram_counts / node_counts, 1u);
+
+                const auto& codes = feature->codes();
+                for (std::size_t first_node = 0; first_node < n_nodes;
+                     first_node += batch_size) {
+                    std::size_t n_batch = std::min(batch_size, n_nodes - first_node);
+                    histograms.resize(n_batch, label_histogram { 0u, n_labels });
+                    for (std::size_t node = 0; node < n_batch; ++node)
+                        histograms[node].reset(n_bins);
+
+                    for (std::size_t i = 0; i < codes.size(); ++i) {
+                        // closed samples wrap round to a large offset and are skipped
+                        std::size_t node = sample_nodes[i] - first_node;
+                        if (node < n_batch)
+                            histograms[node].add(codes[i], labels_[i]);
+                    }
+
+                    for (std::size_t node = 0; node < n_batch; ++node) {
+                        auto [cost, splitting] = m_algo.split_histogram(
+                            histograms[node], feature->edges(), m_cost_fn);
+                        SPDLOG_DEBUG("Calculated split for feature {} with cost {}",
+                            feature_id, cost);
+                        auto& node_best = best[first_node + node];
+                        if (is_better_split(cost, feature_id, node_best)) {
+                            node_best = { cost, { feature_id, splitting } };
+                        }
+                    }
+                }
+            }
+
+            return best;
+        };
+
+        std::size_t n_features = feature_list.size();
+        if (!m_config.parallel_features || m_config.executor_ == nullptr
+            || labels_.size() <= m_config.parallel_features_sample_min
+            || n_features < 2)
+            return find_best(0u, n_features);
+
+        std::size_t n_chunks = std::min(
+            n_features, std::max<std::size_t>(m_config.executor_->concurrency(), 1u));
+        std::vector<std::vector<split_candidate>> chunk_best(n_chunks);
+        m_config.executor_->parallel_for(
+            n_chunks, [&find_best, &chunk_best, n_chunks, n_features](std::size_t c) {
+                chunk_best[c] = find_best(
+                    c * n_features / n_chunks, (c + 1) * n_features / n_chunks);
+            });
+
+        auto best = std::move(chunk_best.front());
+        for (std::size_t c = 1; c < n_chunks; ++c) {
+            for (std::size_t node = 0; node < n_nodes; ++node) {
+                const auto& [cost, split] = chunk_best[c][node];
+                if (is_better_split(cost, split.feature_id_, best[node]))
+                    best[node] = chunk_best[c][node];
+            }
+        }
+        return best;
+    }
+
+    static bool is_better_split(double cost, feature_id id, const split_candidate& best)
+    {
+        return dtree::is_better_split(cost, id, best.first, best.second.feature_id_);
+    }
+
+    /// Sets the splits of the open nodes and moves their samples down to the children,
+    /// returning the locations of the children, the open nodes of the next depth.
+    template <binned_feature_set_c feature_set>
+    std::vector<std::size_t> split_nodes(tree_t& tree, const feature_set& features,
+        const std::vector<split_candidate>& splits,
+        const std::vector<std::size_t>& split_locs,
+        std::vector<std::size_t>& sample_nodes) const
+    {
+        std::vector<const binned_feature*> split_features;
+        split_features.reserve(splits.size());
+        std::vector<std::size_t> child_locs;
+        child_locs.reserve(2 * splits.size());
+
+        for (std::size_t node = 0; node < splits.size(); ++node) {
+            const auto& split = splits[node].second;
+            SPDLOG_DEBUG("Best split found at depth {} on feature {}",
+                tree_t::get_depth(split_locs[node]), split.feature_id_);
+            tree[split_locs[node]] = split;
+
+            split_features.push_back(&features.find(split.feature_id_)->second);
+            child_locs.push_back(tree_t::next(true, split_locs[node]));
+            child_locs.push_back(tree_t::next(false, split_locs[node]));
+        }
+
+        for (std::size_t i = 0; i < sample_nodes.size(); ++i) {
+            auto& node = sample_nodes[i];
+            if (node == closed)
+                continue;
+
+            bool lower = splits[node].second.splitting((*split_features[node])[i]);
+            node = 2 * node + (lower ? 0u : 1u);
+        }
+
+        return child_locs;
+    }
+
+    tree_builder_config m_config;
+
+    algo_t m_algo;
+
+    cost_fn_t m_cost_fn;
+};
+
+} // dtree
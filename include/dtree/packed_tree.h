@@ -0,0 +1,362 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "dtree/flat_tree.h"
+#include "dtree/splittings.h"
+#include "dtree/types.h"
+
+namespace dtree {
+
+/// packed_node
+///
+/// A node of a packed_tree in 8 bytes. A sample goes to the lower child of a split
+/// when the bin code of its feature is at most the threshold, the lower child being at
+/// child and the upper one next to it. A leaf has no feature and child holds the
+/// probability of label 1 as the bits of a float for a binary_leaf, otherwise the
+/// position of its distribution in the tree's pool of them.
+struct packed_node {
+    static constexpr std::uint16_t no_feature = UINT16_MAX;
+
+    bool operator==(const packed_node&) const = default;
+
+    bool is_leaf() const { return feature_id == no_feature; }
+
+    std::uint16_t feature_id;
+    std::uint16_t threshold;
+    std::uint32_t child;
+};
+
+/// packed_cuts
+///
+/// The sorted cuts of every feature that a packed_tree bins a sample against, the code
+/// of a value for a feature being the number of its cuts below the value. As
+/// x <= cuts[k] holds exactly when the code of x is at most k, a tree whose
+/// thresholds are all cuts can compare codes in place of values. One table can be
+/// shared by all the trees of a model (see make_packed_cuts), a sample then being
+/// binned once for all of them.
+class packed_cuts {
+public:
+    using size_type = std::uint32_t;
+
+    using code_type = std::uint16_t;
+
+    static constexpr std::size_t max_cuts = UINT16_MAX;
+
+    packed_cuts()
+        : m_cuts_begin { 0u }
+        , m_cuts {}
+    {
+    }
+
+    /// The cuts of feature f being cuts[f], which are sorted and made unique, e.g. the
+    /// quantile_edges the features of a model were binned with.
+    explicit packed_cuts(std::vector<std::vector<double>> cuts)
+        : packed_cuts {}
+    {
+        for (std::size_t feature_id = 0; feature_id < cuts.size(); ++feature_id) {
+            auto& feature_cuts = cuts[feature_id];
+            std::sort(begin(feature_cuts), end(feature_cuts));
+            feature_cuts.erase(
+                std::unique(begin(feature_cuts), end(feature_cuts)), end(feature_cuts));
+            if (feature_cuts.size() > max_cuts) {
+                std::stringstream msg;
+                msg << "Feature " << feature_id << " has " << feature_cuts.size()
+                    << " cuts, more than a packed_tree can bin";
+                throw std::runtime_error { msg.str() };
+            }
+            m_cuts.insert(m_cuts.end(), begin(feature_cuts), end(feature_cuts));
+            m_cuts_begin.push_back(static_cast<size_type>(m_cuts.size()));
+        }
+    }
+
+    packed_cuts(std::vector<size_type> cuts_begin, std::vector<double> cuts)
+        : m_cuts_begin { std::move(cuts_begin) }
+        , m_cuts { std::move(cuts) }
+    {
+    }
+
+    bool operator==(const packed_cuts&) const = default;
+
+    /// The number of features a binned sample has a code for.
+    std::size_t number_of_features() const { return m_cuts_begin.size() - 1; }
+
+    /// Where the cuts of every feature start, those of feature f being at
+    /// cuts_begin()[f] up to cuts_begin()[f + 1].
+    const std::vector<size_type>& cuts_begin() const { return m_cuts_begin; }
+
+    const std::vector<double>& cuts() const { return m_cuts; }
+
+    /// The code of a value of a feature, the number of its cuts below the value. NaN
+    /// is above every cut as no x <= t holds for it.
+    code_type bin(std::size_t feature_id, double x) const
+    {
+        auto first = m_cuts.begin() + m_cuts_begin[feature_id];
+        auto last = m_cuts.begin() + m_cuts_begin[feature_id + 1];
+        auto it = std::isnan(x) ? last : std::lower_bound(first, last, x);
+        return static_cast<code_type>(it - first);
+    }
+
+    /// The code of a split threshold, which has to be one of the cuts of its feature
+    /// for the codes to split the samples as the threshold does.
+    code_type bin_threshold(std::size_t feature_id, double threshold) const
+    {
+        if (feature_id < number_of_features()) {
+            auto first = m_cuts.begin() + m_cuts_begin[feature_id];
+            auto last = m_cuts.begin() + m_cuts_begin[feature_id + 1];
+            auto it = std::lower_bound(first, last, threshold);
+            if (it != last && *it == threshold)
+                return static_cast<code_type>(it - first);
+        }
+        std::stringstream msg;
+        msg << "The threshold " << threshold << " of feature " << feature_id
+            << " is not one of its cuts";
+        throw std::runtime_error { msg.str() };
+    }
+
+    /// Writes the code of every feature of the sample, codes having an entry per
+    /// feature. Features without cuts are left alone.
+    template <typename sample_t>
+    void bin_sample(const sample_t& sample, std::span<code_type> codes) const
+    {
+        std::size_t n_features = number_of_features();
+        for (std::size_t feature_id = 0; feature_id < n_features; ++feature_id) {
+            if (m_cuts_begin[feature_id] != m_cuts_begin[feature_id + 1])
+                codes[feature_id] = bin(feature_id, sample[feature_id]);
+        }
+    }
+
+private:
+    std::vector<size_type> m_cuts_begin;
+
+    std::vector<double> m_cuts;
+};
+
+/// Adds the thresholds of the splits of the tree to those of their features.
+template <typename leaf_t>
+void collect_thresholds(const flat_tree<node<single_numeric_splitting>, leaf_t>& tree,
+    std::vector<std::vector<double>>& thresholds)
+{
+    using split_type = node<single_numeric_splitting>;
+    if (tree.data().empty())
+        return;
+
+    std::vector<std::size_t> locs { 0u };
+    while (!locs.empty()) {
+        std::size_t loc = locs.back();
+        locs.pop_back();
+        if (const auto* split = std::get_if<split_type>(&tree[loc])) {
+            if (split->feature_id_ >= thresholds.size())
+                thresholds.resize(split->feature_id_ + 1);
+            thresholds[split->feature_id_].push_back(split->splitting.split);
+            locs.push_back(tree.next(true, loc));
+            locs.push_back(tree.next(false, loc));
+        }
+    }
+}
+
+/// The cuts of every threshold of the trees, for the packed_trees of a model to share.
+template <std::ranges::input_range trees_t>
+std::shared_ptr<const packed_cuts> make_packed_cuts(const trees_t& trees)
+{
+    std::vector<std::vector<double>> thresholds;
+    for (const auto& tree : trees)
+        collect_thresholds(tree, thresholds);
+    return std::make_shared<const packed_cuts>(std::move(thresholds));
+}
+
+/// packed_tree
+///
+/// An inference only form of a tree of single numeric splits, small enough that many
+/// trees share the L2 cache. A sample is binned against a packed_cuts holding every
+/// threshold of the tree and a split compares two codes, reaching the same leaf as the
+/// flat_tree it was compiled from. The cuts are either the tree's own or shared by the
+/// trees of a model so that a sample is binned once for all of them. The nodes are
+/// laid out as in a compact_tree, breadth first with siblings next to each other, and
+/// the leaf values are single precision.
+template <typename leaf_t> class packed_tree {
+public:
+    using leaf_type = leaf_t;
+
+    using size_type = std::uint32_t;
+
+    using code_type = packed_cuts::code_type;
+
+    using split_type = node<single_numeric_splitting>;
+
+    /// The value of a leaf, the probability of label 1 for a binary_leaf and otherwise
+    /// its distribution, padded with zeros to the width of the tree.
+    using value_type = std::conditional_t<std::is_same_v<leaf_t, binary_leaf>, float,
+        std::span<const float>>;
+
+    packed_tree()
+        : m_nodes {}
+        , m_cuts { std::make_shared<const packed_cuts>() }
+        , m_values {}
+        , m_width { 1u }
+    {
+    }
+
+    /// Compiles the tree against cuts of its own thresholds.
+    explicit packed_tree(const flat_tree<split_type, leaf_t>& tree)
+        : packed_tree { tree, make_packed_cuts(std::span { &tree, 1 }) }
+    {
+    }
+
+    /// Compiles the tree against cuts shared with other trees, which have to include
+    /// every threshold of the tree.
+    packed_tree(
+        const flat_tree<split_type, leaf_t>& tree, std::shared_ptr<const packed_cuts> cuts)
+        : m_nodes {}
+        , m_cuts { std::move(cuts) }
+        , m_values {}
+        , m_width { 1u }
+    {
+        if (tree.data().empty())
+            return;
+
+        std::vector<std::size_t> flat_locs { 0u };
+        for (std::size_t i = 0; i < flat_locs.size(); ++i) {
+            std::size_t loc = flat_locs[i];
+            if (const auto* split = std::get_if<split_type>(&tree[loc])) {
+                if (split->feature_id_ >= packed_node::no_feature) {
+                    std::stringstream msg;
+                    msg << "Feature " << split->feature_id_
+                        << " is beyond the features a packed_tree can split on";
+                    throw std::runtime_error { msg.str() };
+                }
+                flat_locs.push_back(tree.next(true, loc));
+                flat_locs.push_back(tree.next(false, loc));
+            }
+        }
+
+        std::vector<const leaf_t*> leaves;
+        std::size_t n_splits = 0;
+        for (std::size_t loc : flat_locs) {
+            packed_node node {};
+            if (const auto* split = std::get_if<split_type>(&tree[loc])) {
+                auto feature_id = static_cast<std::uint16_t>(split->feature_id_);
+                node.feature_id = feature_id;
+                node.threshold = m_cuts->bin_threshold(feature_id, split->splitting.split);
+                node.child = static_cast<size_type>(2 * ++n_splits - 1);
+            } else {
+                const auto& leaf = std::get<leaf_t>(tree[loc]);
+                node.feature_id = packed_node::no_feature;
+                if constexpr (std::is_same_v<leaf_t, binary_leaf>) {
+                    node.child = std::bit_cast<std::uint32_t>(
+                        static_cast<float>(leaf.probability()));
+                } else {
+                    node.child = static_cast<size_type>(leaves.size());
+                    leaves.push_back(&leaf);
+                }
+            }
+            m_nodes.push_back(node);
+        }
+
+        if constexpr (!std::is_same_v<leaf_t, binary_leaf>) {
+            for (const auto* leaf : leaves) {
+                auto size = static_cast<size_type>(leaf->value().size());
+                m_width = std::max(m_width, size);
+            }
+            m_values.resize(leaves.size() * m_width, 0.0f);
+            for (std::size_t l = 0; l < leaves.size(); ++l) {
+                auto row = m_values.begin() + l * m_width;
+                std::ranges::transform(leaves[l]->value(), row,
+                    [](double p) { return static_cast<float>(p); });
+            }
+        }
+    }
+
+    packed_tree(std::vector<packed_node> nodes, std::shared_ptr<const packed_cuts> cuts,
+        std::vector<float> values, size_type width)
+        : m_nodes { std::move(nodes) }
+        , m_cuts { std::move(cuts) }
+        , m_values { std::move(values) }
+        , m_width { width }
+    {
+    }
+
+    bool operator==(const packed_tree& other) const
+    {
+        return m_nodes == other.m_nodes && *m_cuts == *other.m_cuts
+            && m_values == other.m_values && m_width == other.m_width;
+    }
+
+    const packed_node& operator[](size_type loc) const { return m_nodes[loc]; }
+
+    size_type size() const { return static_cast<size_type>(m_nodes.size()); }
+
+    /// The number of features a binned sample has a code for.
+    std::size_t number_of_features() const { return m_cuts->number_of_features(); }
+
+    /// The number of values in the row of a leaf.
+    size_type width() const { return m_width; }
+
+    const std::vector<packed_node>& nodes() const { return m_nodes; }
+
+    /// The cuts the codes of a sample are against.
+    const packed_cuts& cuts() const { return *m_cuts; }
+
+    const std::shared_ptr<const packed_cuts>& shared_cuts() const { return m_cuts; }
+
+    /// The pooled distributions of the leaves, empty for a binary_leaf.
+    const std::vector<float>& values() const { return m_values; }
+
+    /// The value of a leaf node.
+    value_type value(const packed_node& node) const
+    {
+        if constexpr (std::is_same_v<leaf_t, binary_leaf>)
+            return std::bit_cast<float>(node.child);
+        else
+            return { m_values.data() + std::size_t { node.child } * m_width, m_width };
+    }
+
+    /// The location of the leaf a binned sample reaches.
+    size_type find_leaf(std::span<const code_type> codes) const
+    {
+        size_type loc = 0;
+        while (!m_nodes[loc].is_leaf()) {
+            const auto& node = m_nodes[loc];
+            loc = node.child + (codes[node.feature_id] > node.threshold);
+        }
+        return loc;
+    }
+
+    /// The value of the leaf a binned sample reaches.
+    value_type apply_binned(std::span<const code_type> codes) const
+    {
+        return value(m_nodes[find_leaf(codes)]);
+    }
+
+    /// The value of the leaf a sample of raw values reaches, binning it into codes,
+    /// which have an entry per feature of the cuts. Trees sharing their cuts should
+    /// rather bin a sample once with cuts().bin_sample and use apply_binned.
+    template <typename sample_t>
+    value_type apply(const sample_t& sample, std::span<code_type> codes) const
+    {
+        m_cuts->bin_sample(sample, codes);
+        return apply_binned(codes);
+    }
+
+private:
+    std::vector<packed_node> m_nodes;
+
+    std::shared_ptr<const packed_cuts> m_cuts;
+
+    std::vector<float> m_values;
+
+    size_type m_width;
+};
+
+} // namespace dtree
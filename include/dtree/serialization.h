@@ -6,7 +6,9 @@
 #include <boost/serialization/variant.hpp>
 #include <boost/serialization/vector.hpp>
 
+#include "dtree/compact_tree.h"
 #include "dtree/flat_tree.h"
+#include "dtree/packed_tree.h"
 #include "dtree/splittings.h"
 #include "dtree/types.h"
 
@@ -89,6 +91,12 @@ void serialize(
     archive& make_nvp("length", splitting.length);
 }
 
+template <typename archive_t>
+void serialize(archive_t& archive, dtree::category_splitting& splitting, unsigned int)
+{
+    archive& make_nvp("categories", splitting.categories);
+}
+
 template <typename archive_t, typename... splitting_ts>
 void serialize(
     archive_t& archive, dtree::splitting_variant<splitting_ts...>& v, unsigned int)
@@ -116,6 +124,27 @@ void serialize(archive_t& archive, dtree::leaf& leaf, unsigned int version)
     split_free(archive, leaf, version);
 }
 
+template <typename archive_t>
+void save(archive_t& archive, const dtree::binary_leaf& leaf, unsigned int)
+{
+    double probability = leaf.probability();
+    archive& BOOST_SERIALIZATION_NVP(probability);
+}
+
+template <typename archive_t>
+void load(archive_t& archive, dtree::binary_leaf& leaf, unsigned int)
+{
+    double probability;
+    archive >> BOOST_SERIALIZATION_NVP(probability);
+    leaf = dtree::binary_leaf { probability };
+}
+
+template <typename archive_t>
+void serialize(archive_t& archive, dtree::binary_leaf& leaf, unsigned int version)
+{
+    split_free(archive, leaf, version);
+}
+
 template <typename archive_t, typename splitting_t>
 void serialize(archive_t& archive, dtree::node<splitting_t>& node, unsigned int)
 {
@@ -123,23 +152,111 @@ void serialize(archive_t& archive, dtree::node<splitting_t>& node, unsigned int)
     archive& make_nvp("splitting", node.splitting);
 }
 
-template <typename archive_t, typename split_t>
-void save(archive_t& archive, const dtree::flat_tree<split_t>& tree, unsigned int)
+template <typename archive_t, typename split_t, typename leaf_t>
+void save(
+    archive_t& archive, const dtree::flat_tree<split_t, leaf_t>& tree, unsigned int)
 {
     archive& make_nvp("data", tree.data());
 }
 
-template <typename archive_t, typename split_t>
-void load(archive_t& archive, dtree::flat_tree<split_t>& tree, unsigned int)
+template <typename archive_t, typename split_t, typename leaf_t>
+void load(archive_t& archive, dtree::flat_tree<split_t, leaf_t>& tree, unsigned int)
 {
-    using container_t = dtree::flat_tree<split_t>::container_t;
+    using container_t = dtree::flat_tree<split_t, leaf_t>::container_t;
     container_t container;
     archive >> make_nvp("data", container);
-    tree = dtree::flat_tree<split_t> { std::move(container) };
+    tree = dtree::flat_tree<split_t, leaf_t> { std::move(container) };
+}
+
+template <typename archive_t, typename split_t, typename leaf_t>
+void serialize(
+    archive_t& archive, dtree::flat_tree<split_t, leaf_t>& tree, unsigned int version)
+{
+    split_free(archive, tree, version);
 }
 
-template <typename archive_t, typename split_t>
-void serialize(archive_t& archive, dtree::flat_tree<split_t>& tree, unsigned int version)
+template <typename archive_t, typename payload_t>
+void serialize(archive_t& archive, dtree::compact_node<payload_t>& node, unsigned int)
+{
+    archive& make_nvp("split", node.split);
+    archive& make_nvp("feature_id", node.feature_id);
+    archive& make_nvp("child", node.child);
+}
+
+template <typename archive_t, typename split_t, typename leaf_t>
+void save(
+    archive_t& archive, const dtree::compact_tree<split_t, leaf_t>& tree, unsigned int)
+{
+    auto width = tree.width();
+    archive& make_nvp("nodes", tree.nodes());
+    archive& make_nvp("splittings", tree.splittings());
+    archive& make_nvp("values", tree.values());
+    archive& BOOST_SERIALIZATION_NVP(width);
+}
+
+template <typename archive_t, typename split_t, typename leaf_t>
+void load(archive_t& archive, dtree::compact_tree<split_t, leaf_t>& tree, unsigned int)
+{
+    using tree_t = dtree::compact_tree<split_t, leaf_t>;
+    std::vector<typename tree_t::node_type> nodes;
+    std::vector<decltype(split_t::splitting)> splittings;
+    std::vector<double> values;
+    typename tree_t::size_type width;
+    archive >> make_nvp("nodes", nodes);
+    archive >> make_nvp("splittings", splittings);
+    archive >> make_nvp("values", values);
+    archive >> BOOST_SERIALIZATION_NVP(width);
+    tree = tree_t { std::move(nodes), std::move(splittings), std::move(values), width };
+}
+
+template <typename archive_t, typename split_t, typename leaf_t>
+void serialize(
+    archive_t& archive, dtree::compact_tree<split_t, leaf_t>& tree, unsigned int version)
+{
+    split_free(archive, tree, version);
+}
+
+template <typename archive_t>
+void serialize(archive_t& archive, dtree::packed_node& node, unsigned int)
+{
+    archive& make_nvp("feature_id", node.feature_id);
+    archive& make_nvp("threshold", node.threshold);
+    archive& make_nvp("child", node.child);
+}
+
+template <typename archive_t, typename leaf_t>
+void save(archive_t& archive, const dtree::packed_tree<leaf_t>& tree, unsigned int)
+{
+    auto width = tree.width();
+    archive& make_nvp("nodes", tree.nodes());
+    archive& make_nvp("cuts_begin", tree.cuts().cuts_begin());
+    archive& make_nvp("cuts", tree.cuts().cuts());
+    archive& make_nvp("values", tree.values());
+    archive& BOOST_SERIALIZATION_NVP(width);
+}
+
+template <typename archive_t, typename leaf_t>
+void load(archive_t& archive, dtree::packed_tree<leaf_t>& tree, unsigned int)
+{
+    using tree_t = dtree::packed_tree<leaf_t>;
+    std::vector<dtree::packed_node> nodes;
+    std::vector<dtree::packed_cuts::size_type> cuts_begin;
+    std::vector<double> cuts;
+    std::vector<float> values;
+    typename tree_t::size_type width;
+    archive >> make_nvp("nodes", nodes);
+    archive >> make_nvp("cuts_begin", cuts_begin);
+    archive >> make_nvp("cuts", cuts);
+    archive >> make_nvp("values", values);
+    archive >> BOOST_SERIALIZATION_NVP(width);
+    tree = tree_t { std::move(nodes),
+        std::make_shared<const dtree::packed_cuts>(std::move(cuts_begin), std::move(cuts)),
+        std::move(values), width };
+}
+
+template <typename archive_t, typename leaf_t>
+void serialize(
+    archive_t& archive, dtree::packed_tree<leaf_t>& tree, unsigned int version)
 {
     split_free(archive, tree, version);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <numeric>
 #include <sstream>
 #include <variant>
@@ -53,6 +54,23 @@ struct string_length_splitting {
     std::size_t length;
 };
 
+/// category_splitting
+///
+/// The lower side of the split is a subset of the categories, held as a bitset over
+/// their codes so applying it is a single lookup. Codes past the end of the bitset,
+/// including those of categories unknown in training, are on the upper side.
+struct category_splitting {
+    bool operator()(category sample) const
+    {
+        std::size_t word = sample.code / 64;
+        return word < categories.size() && (categories[word] >> (sample.code % 64)) & 1u;
+    }
+
+    bool operator==(const category_splitting&) const = default;
+
+    std::vector<std::uint64_t> categories;
+};
+
 template <typename... splitting_ts> struct splitting_variant {
     template <typename... Ts> bool operator()(const std::variant<Ts...>& sample) const
     {
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace dtree {
+
+/// suffix_automaton
+///
+/// A generalised suffix automaton over texts added one at a time: the smallest
+/// automaton accepting the suffixes of all of them. Each state stands for the
+/// substrings that end at exactly the same positions of the texts, which are the
+/// suffixes of its longest substring down to one character longer than the longest of
+/// its suffix link. There are fewer than twice as many states as characters added, so
+/// every distinct substring of the texts is reached in space linear in their length.
+/// Each state also keeps one place its substrings end, as the id of the text and the
+/// position of the last character, so that they can be read back.
+class suffix_automaton {
+public:
+    static constexpr std::uint32_t no_state = UINT32_MAX;
+
+    suffix_automaton();
+
+    /// Adds the suffixes of the text, reporting its occurrences under the id.
+    void add(std::string_view text, std::size_t id);
+
+    std::size_t number_of_states() const { return m_states.size(); }
+
+    /// The length of the longest substring of the state.
+    std::size_t length(std::uint32_t state) const { return m_states[state].length; }
+
+    std::uint32_t link(std::uint32_t state) const { return m_states[state].link; }
+
+    /// The id of a text containing the substrings of the state and the position in it
+    /// of their last character.
+    std::pair<std::size_t, std::size_t> end(std::uint32_t state) const
+    {
+        return { m_states[state].text, m_states[state].end };
+    }
+
+    /// The state reached from the state on reading c, no_state if there is none.
+    std::uint32_t next(std::uint32_t state, unsigned char c) const
+    {
+        for (auto [edge_c, target] : m_states[state].edges) {
+            if (edge_c == c)
+                return target;
+        }
+        return no_state;
+    }
+
+    /// Calls on_state(state) once for every state with substrings in the text, which
+    /// must be one of those added. Reading the text from the root reaches the state
+    /// of each prefix, and the states of the other substrings are on the suffix links
+    /// from there. visited has an entry per state and is marked with the stamp for
+    /// each state reported, and the walk up the links stops at a marked state as those
+    /// further up have been reported too. Giving each text a new stamp saves clearing
+    /// visited between texts.
+    template <typename on_state_t>
+    void for_each_state(std::string_view text, std::span<std::uint32_t> visited,
+        std::uint32_t stamp, on_state_t&& on_state) const
+    {
+        std::uint32_t state = 0;
+        for (unsigned char c : text) {
+            state = next(state, c);
+            for (std::uint32_t s = state; s != 0 && visited[s] != stamp;
+                 s = m_states[s].link) {
+                visited[s] = stamp;
+                on_state(s);
+            }
+        }
+    }
+
+private:
+    struct state {
+        std::vector<std::pair<unsigned char, std::uint32_t>> edges;
+        std::uint32_t link;
+        std::size_t length;
+        std::size_t text;
+        std::size_t end;
+    };
+
+    void set_next(std::uint32_t state, unsigned char c, std::uint32_t target);
+
+    std::uint32_t clone(std::uint32_t p, std::uint32_t q, unsigned char c);
+
+    std::uint32_t extend(
+        std::uint32_t last, unsigned char c, std::size_t text, std::size_t end);
+
+    std::vector<state> m_states;
+};
+
+} // namespace dtree
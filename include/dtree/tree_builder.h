@@ -1,13 +1,24 @@
 #pragma once
 
+#include <algorithm>
 #include <future>
+#include <memory_resource>
 #include <numeric>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <stdexcept>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <spdlog/spdlog.h>
 
+#include "dtree/arena.h"
+#include "dtree/binning.h"
 #include "dtree/concepts.h"
+#include "dtree/dataset.h"
+#include "dtree/executor.h"
 #include "dtree/flat_tree.h"
 #include "dtree/labels.h"
 #include "dtree/types.h"
@@ -15,18 +26,68 @@
 namespace dtree {
 
 struct tree_builder_config {
+    /// build the sub trees of nodes with more than async_sample_min samples in
+    /// parallel, on the executor if one is set and otherwise with std::async
     bool async;
     std::size_t async_sample_min;
     /// stopping conditions
     std::size_t max_depth;
     std::size_t min_samples;
     double probability_limit;
+    /// sort each single numeric feature once up front and keep the samples of every
+    /// node in that order, only used when the algo is a presorted_algo_c
+    bool presort = false;
+    /// keep the features immutable and give every node a slice of a single buffer of
+    /// sample indices, partitioned in place, rather than copying the features of each
+    /// node. Used when the algo can split views of the features and labels. Otherwise
+    /// the samples of every node of a dataset are copied into a dataset of their own,
+    /// so the algos always see contiguous columns
+    bool in_place = false;
+    /// evaluate the features of nodes with more than parallel_features_sample_min
+    /// samples in parallel chunks on the executor, which must be set. Uses every
+    /// thread near the root where there are too few sub trees to build in parallel
+    bool parallel_features = false;
+    std::size_t parallel_features_sample_min = 0u;
+    /// the most label counts the level wise builder holds per feature at once, the
+    /// open nodes of a depth are histogrammed in batches of nodes that fit
+    std::size_t max_histogram_counts = std::size_t { 1 } << 22;
+    /// not owned, it must outlive any builds using it
+    executor* executor_ = nullptr;
 };
 
+// TODO - document/code the return type
+int should_stop(const tree_builder_config& config, std::size_t current_depth,
+    const label_counts& counts, std::size_t n_samples);
+
+/// Whether a split improves on the best so far. Ties go to the lowest feature id so the
+/// tree doesn't depend on the order the features are visited in, which changes between
+/// the copied feature sets of each node.
+inline bool is_better_split(
+    double cost, feature_id id, double best_cost, feature_id best_id)
+{
+    return cost < best_cost || (cost == best_cost && id < best_id);
+}
+
+/// Throws unless the labels fit the algo, which for an algo specialised to a number
+/// of classes means none of them is n_classes or more.
+template <typename algo_t> void check_number_of_labels(std::size_t n_labels)
+{
+    if constexpr (requires { algo_t::n_classes; }) {
+        if (algo_t::n_classes != 0 && n_labels > algo_t::n_classes) {
+            std::stringstream msg;
+            msg << "The algo is specialised to " << algo_t::n_classes
+                << " classes but the labels have " << n_labels;
+
+            throw std::runtime_error { msg.str() };
+        }
+    }
+}
+
 template <typename algo_t, typename cost_fn_t> class tree_builder {
 public:
     using node_type = node<typename algo_t::splitting_type>;
     using tree_t = flat_tree_t<algo_t>;
+    using leaf_t = tree_t::leaf_type;
 
     tree_builder(const tree_builder_config& config)
         : m_config { config }
@@ -42,61 +103,223 @@ public:
     {
     }
 
-    template <typename feature_set>
-    tree_t build(const feature_set& features, const labels& labels_) const
+    template <typename feature_set, typename label_t>
+    tree_t build(const feature_set& features, const basic_labels<label_t>& labels_) const
     {
+        using labels_t = basic_labels<label_t>;
+        check_number_of_labels<algo_t>(labels_.number_of_labels());
         tree_t tree { m_config.max_depth };
+
+        // with nothing to split on the root is a leaf
+        if (features.size() == 0u) {
+            tree[0] = make_leaf<leaf_t>(labels_.get_label_counts());
+            return tree;
+        }
+
+        if constexpr (single_numeric_feature_set_c<feature_set>
+            && presorted_algo_c<algo_t, const cost_fn_t&>) {
+            if (m_config.presort) {
+                build_presorted(tree, features, labels_);
+                return tree;
+            }
+        }
+
+        if constexpr (binned_feature_set_c<feature_set>
+            && histogram_algo_c<algo_t, const cost_fn_t&>) {
+            build_histograms(tree, features, labels_);
+            return tree;
+        }
+
+        if constexpr (splits_in_place<feature_set, labels_t>()) {
+            if (m_config.in_place) {
+                build_in_place(tree, features, labels_);
+                return tree;
+            }
+        }
+
         build(tree, 0u, features, labels_);
         return tree;
     }
 
 private:
-    // TODO - document/code the return type
-    // TODO - src?
-    int should_stop(std::size_t current_depth, const labels& labels_) const
+    /// The samples of the feature at the given locations, without copying them.
+    template <typename feature_t>
+    static auto index_view(const feature_t& feature, std::span<const std::size_t> index)
     {
-        if (current_depth >= m_config.max_depth)
-            return 101;
-        if (labels_.size() <= m_config.min_samples)
-            return 102;
+        return index
+            | std::views::transform(
+                [&feature](std::size_t i) -> decltype(auto) { return feature[i]; });
+    }
 
-        const auto& dist = labels_.calculate_distribution();
-        auto max_p = std::max_element(begin(dist), end(dist));
-        if (*max_p >= m_config.probability_limit)
-            return 103;
-        return 0;
+    template <typename feature_t>
+    using index_view_t = decltype(index_view(
+        std::declval<const feature_t&>(), std::declval<std::span<const std::size_t>>()));
+
+    template <typename feature_t, typename labels_t>
+    static constexpr bool splits_index_view()
+    {
+        return std::is_invocable_v<const algo_t&, index_view_t<feature_t>,
+            const labels_view<labels_t>&, const cost_fn_t&>;
     }
 
-    template <typename feature_set>
-    node_type find_split(const feature_set& features, const labels& labels_) const
+    template <typename feature_set, typename labels_t>
+    static constexpr bool splits_in_place()
     {
-        double best_cost = std::numeric_limits<double>::max();
-        typename algo_t::splitting_type best_split;
-        feature_id best_feature_id = std::numeric_limits<feature_id>::max();
+        using feature_t = feature_set::mapped_type;
+        if constexpr (mixed_feature_c<feature_t>) {
+            return []<typename... Ts>(std::type_identity<std::variant<Ts...>>) {
+                return (splits_index_view<Ts, labels_t>() && ...);
+            }(std::type_identity<feature_t> {});
+        } else {
+            return splits_index_view<feature_t, labels_t>();
+        }
+    }
 
+    /// The samples of a presorted build. Each feature has its sample indices sorted by
+    /// value and the samples of a node are the same slice [first, last) of every one
+    /// of these orders. Splitting a node stably partitions the slice so that the
+    /// children are again sorted.
+    template <typename feature_t, typename labels_t> struct presorted_samples {
+        const labels_t& labels_;
+        std::vector<std::pair<feature_id, const feature_t*>> features;
+        std::vector<std::vector<std::size_t>> orders;
+        // which side of the current split each sample falls, nodes being built
+        // concurrently never share samples so this can be shared
+        std::vector<char> lower;
+    };
+
+    /// The features of a node in a fixed order, so they can be split by position. The
+    /// list is scratch, see scratch_scope.
+    template <typename feature_set>
+    static auto list_features(const feature_set& features)
+    {
+        using feature_t = feature_set::mapped_type;
+        std::pmr::vector<std::pair<feature_id, const feature_t*>> feature_list {
+            &scratch_arena()
+        };
+        feature_list.reserve(features.size());
         for (const auto& [feature_id, feature] : features) {
-            auto [cost, split] = m_algo(feature, labels_, m_cost_fn);
-            SPDLOG_DEBUG(
-                "Calculated split for feature {} with cost {}", feature_id, cost);
-            if (cost < best_cost) {
-                best_cost = cost;
-                best_split = split;
-                best_feature_id = feature_id;
+            feature_list.emplace_back(feature_id, &feature);
+        }
+        return feature_list;
+    }
+
+    using split_candidate = std::pair<double, node_type>;
+
+    /// The best split of a node over its n_features features, split_fn(k) giving the
+    /// cost and split of the kth. Large enough nodes evaluate contiguous chunks of the
+    /// features in parallel (see tree_builder_config::parallel_features) and then
+    /// reduce the best of each chunk, which is_better_split makes independent of how
+    /// the features were chunked.
+    template <typename split_fn_t>
+    node_type find_best_split(
+        std::size_t n_samples, std::size_t n_features, const split_fn_t& split_fn) const
+    {
+        auto find_best = [&split_fn](std::size_t first, std::size_t last) {
+            split_candidate best { std::numeric_limits<double>::max(),
+                { std::numeric_limits<feature_id>::max(), {} } };
+            for (std::size_t k = first; k < last; ++k) {
+                split_candidate candidate = split_fn(k);
+                SPDLOG_DEBUG("Calculated split for feature {} with cost {}",
+                    candidate.second.feature_id_, candidate.first);
+                if (is_better_split(candidate, best))
+                    best = std::move(candidate);
             }
+            return best;
+        };
+
+        if (!m_config.parallel_features || m_config.executor_ == nullptr
+            || n_samples <= m_config.parallel_features_sample_min || n_features < 2)
+            return find_best(0u, n_features).second;
+
+        std::size_t n_chunks = std::min(
+            n_features, std::max<std::size_t>(m_config.executor_->concurrency(), 1u));
+        std::vector<split_candidate> chunk_best(n_chunks);
+        m_config.executor_->parallel_for(
+            n_chunks, [&find_best, &chunk_best, n_chunks, n_features](std::size_t c) {
+                chunk_best[c] = find_best(
+                    c * n_features / n_chunks, (c + 1) * n_features / n_chunks);
+            });
+
+        auto best = begin(chunk_best);
+        for (auto it = std::next(best); it != end(chunk_best); ++it) {
+            if (is_better_split(*it, *best))
+                best = it;
         }
+        return best->second;
+    }
 
-        return { best_feature_id, best_split };
+    static bool is_better_split(
+        const split_candidate& split, const split_candidate& best)
+    {
+        return dtree::is_better_split(
+            split.first, split.second.feature_id_, best.first, best.second.feature_id_);
+    }
+
+    template <typename feature_set, labels_c labels_t>
+    node_type find_split(const feature_set& features, const labels_t& labels_) const
+    {
+        scratch_scope scope;
+        auto feature_list = list_features(features);
+        return find_best_split(labels_.size(), feature_list.size(),
+            [this, &feature_list, &labels_](std::size_t k) {
+                const auto& [feature_id, feature] = feature_list[k];
+                auto [cost, splitting] = split_feature(*feature, labels_);
+                return split_candidate { cost, { feature_id, splitting } };
+            });
+    }
+
+    /// As find_split for the samples at the locations in index, see build_in_place.
+    template <typename feature_set, typename labels_t>
+    node_type find_split(const feature_set& features,
+        const labels_view<labels_t>& labels_, std::span<const std::size_t> index) const
+    {
+        scratch_scope scope;
+        auto feature_list = list_features(features);
+        return find_best_split(index.size(), feature_list.size(),
+            [this, &feature_list, &labels_, index](std::size_t k) {
+                const auto& [feature_id, feature] = feature_list[k];
+                auto [cost, splitting] = split_feature(*feature, labels_, index);
+                return split_candidate { cost, { feature_id, splitting } };
+            });
+    }
+
+    template <typename feature_t, labels_c labels_t>
+    std::pair<double, typename algo_t::splitting_type> split_feature(
+        const feature_t& feature, const labels_t& labels_) const
+    {
+        return m_algo(feature, labels_, m_cost_fn);
+    }
+
+    /// Splits the samples of a feature at the node's locations, see build_in_place.
+    template <typename feature_t, typename labels_t>
+    std::pair<double, typename algo_t::splitting_type> split_feature(
+        const feature_t& feature, const labels_view<labels_t>& labels_,
+        std::span<const std::size_t> index) const
+    {
+        return m_algo(index_view(feature, index), labels_, m_cost_fn);
+    }
+
+    template <mixed_feature_c feature_t, typename labels_t>
+    std::pair<double, typename algo_t::splitting_type> split_feature(
+        const feature_t& feature, const labels_view<labels_t>& labels_,
+        std::span<const std::size_t> index) const
+    {
+        return std::visit(
+            [this, &labels_, index](
+                const auto& f) { return split_feature(f, labels_, index); },
+            feature);
     }
 
     template <typename feature_set>
-    std::vector<std::size_t> get_split_index(
+    std::pmr::vector<std::size_t> get_split_index(
         bool lower, const feature_set& features, const node_type& node) const
     {
         return do_index_split(lower, features.find(node.feature_id_)->second, node);
     }
 
     template <mixed_feature_set_c feature_set>
-    std::vector<std::size_t> get_split_index(
+    std::pmr::vector<std::size_t> get_split_index(
         bool lower, const feature_set& features, const node_type& node) const
     {
         return std::visit(
@@ -105,11 +328,12 @@ private:
             features.find(node.feature_id_)->second);
     }
 
+    /// The locations of the samples on one side of the split, as scratch.
     template <typename feature_t>
-    std::vector<std::size_t> do_index_split(
+    std::pmr::vector<std::size_t> do_index_split(
         bool lower, const feature_t& feature, const node_type& node) const
     {
-        std::vector<std::size_t> split_index;
+        std::pmr::vector<std::size_t> split_index { &scratch_arena() };
         split_index.reserve(feature.size());
 
         for (std::size_t i = 0; i < feature.size(); ++i) {
@@ -123,7 +347,7 @@ private:
 
     template <typename feature_t>
     feature_t do_split_feature(
-        const std::vector<std::size_t>& index, const feature_t& feature) const
+        std::span<const std::size_t> index, const feature_t& feature) const
     {
         feature_t split_feature;
         split_feature.reserve(index.size());
@@ -132,9 +356,21 @@ private:
         return split_feature;
     }
 
+    template <typename feature_t>
+        requires requires(
+            const feature_t& feature, std::span<const std::size_t> index)
+        {
+            { feature.select(index) } -> std::same_as<feature_t>;
+        }
+    feature_t do_split_feature(
+        std::span<const std::size_t> index, const feature_t& feature) const
+    {
+        return feature.select(index);
+    }
+
     template <mixed_feature_c feature_t>
     feature_t do_split_feature(
-        const std::vector<std::size_t>& index, const feature_t& feature) const
+        std::span<const std::size_t> index, const feature_t& feature) const
     {
         return std::visit(
             [this, &index](
@@ -142,14 +378,15 @@ private:
             feature);
     }
 
-    template <typename feature_set>
+    template <typename feature_set, typename labels_t>
     void build(tree_t& tree, std::size_t loc, const feature_set& features,
-        const labels& labels_) const
+        const labels_t& labels_) const
     {
-        if (auto reason = should_stop(tree_t::get_depth(loc), labels_)) {
+        if (auto reason = should_stop(m_config,
+                tree_t::get_depth(loc), labels_.get_label_counts(), labels_.size())) {
             SPDLOG_DEBUG(
                 "Stopping building at depth {} as {}", tree_t::get_depth(loc), reason);
-            tree[loc] = leaf { labels_.calculate_distribution() };
+            tree[loc] = make_leaf<leaf_t>(labels_.get_label_counts());
         } else {
             auto split = find_split(features, labels_);
             SPDLOG_DEBUG("Best split found at depth {} on feature {}",
@@ -160,58 +397,335 @@ private:
         }
     }
 
-    template <typename feature_set>
+    template <typename feature_set, typename labels_t>
     void build_sub_trees(tree_t& tree, std::size_t loc, const feature_set& features,
-        const labels& labels_, const node_type& node) const
+        const labels_t& labels_, const node_type& node) const
     {
-        if (m_config.async && labels_.size() > m_config.async_sample_min) {
-            build_sub_trees_async(tree, loc, features, labels_, node);
+        build_sub_trees(
+            labels_.size(),
+            [this, &tree, &features, &labels_, &node, loc]() {
+                build_sub_tree(tree, loc, true, features, labels_, node);
+            },
+            [this, &tree, &features, &labels_, &node, loc]() {
+                build_sub_tree(tree, loc, false, features, labels_, node);
+            });
+    }
+
+    template <typename lower_fn_t, typename upper_fn_t>
+    void build_sub_trees(
+        std::size_t n_samples, lower_fn_t&& build_lower, upper_fn_t&& build_upper) const
+    {
+        if (m_config.async && n_samples > m_config.async_sample_min) {
+            if (m_config.executor_) {
+                m_config.executor_->invoke(build_lower, build_upper);
+                return;
+            }
+            build_sub_trees_async(build_lower, build_upper);
         } else {
-            build_sub_trees_sync(tree, loc, features, labels_, node);
+            build_sub_trees_sync(build_lower, build_upper);
         }
     }
 
-    template <typename feature_set>
-    void build_sub_trees_async(tree_t& tree, std::size_t loc,
-        const feature_set& features, const labels& labels_, const node_type& node) const
+    template <typename lower_fn_t, typename upper_fn_t>
+    void build_sub_trees_async(lower_fn_t& build_lower, upper_fn_t& build_upper) const
     {
-        auto lower_future = std::async([this, &tree, &features, &labels_, node, loc]() {
-            return build_sub_tree(tree, loc, true, features, labels_, node);
-        });
+        auto lower_future = std::async(build_lower);
 
-        auto upper_future = std::async([this, &tree, &features, &labels_, node, loc]() {
-            return build_sub_tree(tree, loc, false, features, labels_, node);
-        });
+        auto upper_future = std::async(build_upper);
 
         lower_future.get();
         upper_future.get();
     }
 
-    template <typename feature_set>
-    void build_sub_trees_sync(tree_t& tree, std::size_t loc, const feature_set& features,
-        const labels& labels_, const node_type& node) const
+    template <typename lower_fn_t, typename upper_fn_t>
+    void build_sub_trees_sync(lower_fn_t& build_lower, upper_fn_t& build_upper) const
     {
-        build_sub_tree(tree, loc, true, features, labels_, node);
+        build_lower();
 
-        build_sub_tree(tree, loc, false, features, labels_, node);
+        build_upper();
     }
 
-    template <typename feature_set>
+    template <typename feature_set, typename labels_t>
     void build_sub_tree(tree_t& tree, std::size_t parent_loc, bool lower,
-        const feature_set& features, const labels& labels_, const node_type& node) const
+        const feature_set& features, const labels_t& labels_,
+        const node_type& node) const
     {
+        scratch_scope scope;
         auto split_index = get_split_index(lower, features, node);
 
+        auto split_features = do_split_features(split_index, features);
+        labels_t split_labels = do_split_feature(split_index, labels_);
+        std::size_t loc = tree_t::next(lower, parent_loc);
+
+        build(tree, loc, split_features, split_labels);
+    }
+
+    template <typename feature_set>
+    auto do_split_features(
+        std::span<const std::size_t> index, const feature_set& features) const
+    {
         using feature_t = feature_set::mapped_type;
         std::unordered_map<feature_id, feature_t> split_features;
         for (const auto& [feature_id, feature] : features) {
-            split_features.emplace(feature_id, do_split_feature(split_index, feature));
+            split_features.emplace(feature_id, do_split_feature(index, feature));
         }
+        return split_features;
+    }
 
-        labels split_labels = do_split_feature(split_index, labels_);
-        std::size_t loc = tree_t::next(lower, parent_loc);
+    /// The features of a dataset are views, so the samples are copied into a dataset
+    /// of their own.
+    template <dataset_c feature_set>
+    feature_set do_split_features(
+        std::span<const std::size_t> index, const feature_set& features) const
+    {
+        return features.select(index);
+    }
 
-        build(tree, loc, split_features, split_labels);
+    using histogram_map = std::unordered_map<feature_id, label_histogram>;
+
+    template <binned_feature_set_c feature_set, typename labels_t>
+    static histogram_map make_histograms(
+        const feature_set& features, const labels_t& labels_)
+    {
+        histogram_map histograms;
+        for (const auto& [feature_id, feature] : features) {
+            histograms.emplace(feature_id, label_histogram { feature, labels_ });
+        }
+        return histograms;
+    }
+
+    template <binned_feature_set_c feature_set, typename labels_t>
+    void build_histograms(
+        tree_t& tree, const feature_set& features, const labels_t& labels_) const
+    {
+        std::vector<std::size_t> index(labels_.size());
+        std::iota(begin(index), end(index), 0u);
+
+        build_histograms(tree, 0u, features, labels_, std::span { index },
+            make_histograms(features, labels_));
+    }
+
+    /// As build_in_place but the label histograms of the node's features are passed
+    /// down from the parent rather than recounted by the algo. A split partitions the
+    /// node's slice of the indices in one pass, and only the smaller child's samples
+    /// are then counted, the parent's histograms becoming those of the larger child
+    /// once the smaller child's counts are taken off. Neither child's features or
+    /// labels are copied.
+    template <binned_feature_set_c feature_set, typename labels_t>
+    void build_histograms(tree_t& tree, std::size_t loc, const feature_set& features,
+        const labels_t& labels_, std::span<std::size_t> index,
+        histogram_map histograms) const
+    {
+        label_counts counts = count_labels(labels_, index);
+        if (auto reason
+            = should_stop(m_config, tree_t::get_depth(loc), counts, index.size())) {
+            SPDLOG_DEBUG(
+                "Stopping building at depth {} as {}", tree_t::get_depth(loc), reason);
+            tree[loc] = make_leaf<leaf_t>(counts);
+            return;
+        }
+
+        scratch_scope scope;
+        auto feature_list = list_features(features);
+        node_type split = find_best_split(index.size(), feature_list.size(),
+            [this, &feature_list, &histograms = std::as_const(histograms)](
+                std::size_t k) {
+                const auto& [feature_id, feature] = feature_list[k];
+                auto [cost, splitting] = m_algo.split_histogram(
+                    histograms.at(feature_id), feature->edges(), m_cost_fn);
+                return split_candidate { cost, { feature_id, splitting } };
+            });
+        SPDLOG_DEBUG("Best split found at depth {} on feature {}",
+            tree_t::get_depth(loc), split.feature_id_);
+        tree[loc] = split;
+
+        auto middle = partition_index(features.find(split.feature_id_)->second, split,
+            begin(index), end(index));
+        std::size_t n_lower = middle - begin(index);
+        auto lower_index = index.first(n_lower);
+        auto upper_index = index.subspan(n_lower);
+        bool lower_is_smaller = lower_index.size() <= upper_index.size();
+        auto smaller_index = lower_is_smaller ? lower_index : upper_index;
+
+        histogram_map smaller_histograms;
+        for (const auto& [feature_id, feature] : features) {
+            auto& histogram = histograms.at(feature_id);
+            label_histogram smaller_histogram { histogram.number_of_bins(),
+                histogram.number_of_labels() };
+            smaller_histogram.add(feature, labels_, smaller_index);
+
+            histogram -= smaller_histogram;
+            smaller_histograms.emplace(feature_id, std::move(smaller_histogram));
+        }
+
+        auto& lower_histograms = lower_is_smaller ? smaller_histograms : histograms;
+        auto& upper_histograms = lower_is_smaller ? histograms : smaller_histograms;
+
+        build_sub_trees(
+            index.size(),
+            [this, &tree, &features, &labels_, lower_index, &lower_histograms, loc]() {
+                build_histograms(tree, tree_t::next(true, loc), features, labels_,
+                    lower_index, std::move(lower_histograms));
+            },
+            [this, &tree, &features, &labels_, upper_index, &upper_histograms, loc]() {
+                build_histograms(tree, tree_t::next(false, loc), features, labels_,
+                    upper_index, std::move(upper_histograms));
+            });
+    }
+
+    template <typename feature_set, typename labels_t>
+    void build_presorted(
+        tree_t& tree, const feature_set& features, const labels_t& labels_) const
+    {
+        using feature_t = feature_set::mapped_type;
+        presorted_samples<feature_t, labels_t> samples { labels_, {}, {}, {} };
+
+        for (const auto& [feature_id, feature] : features) {
+            std::vector<std::size_t> order(labels_.size());
+            std::iota(begin(order), end(order), 0u);
+            std::stable_sort(begin(order), end(order),
+                [&feature](std::size_t i, std::size_t j) {
+                    return feature[i] < feature[j];
+                });
+
+            samples.features.emplace_back(feature_id, &feature);
+            samples.orders.push_back(std::move(order));
+        }
+        samples.lower.resize(labels_.size());
+
+        build_presorted(tree, 0u, samples, 0u, labels_.size());
+    }
+
+    template <typename feature_t, typename labels_t>
+    void build_presorted(tree_t& tree, std::size_t loc,
+        presorted_samples<feature_t, labels_t>& samples, std::size_t first,
+        std::size_t last) const
+    {
+        auto node_samples = [&samples, first, last](std::size_t index) {
+            return std::span { samples.orders[index] }.subspan(first, last - first);
+        };
+
+        label_counts counts = count_labels(samples.labels_, node_samples(0));
+
+        if (auto reason = should_stop(
+                m_config, tree_t::get_depth(loc), counts, last - first)) {
+            SPDLOG_DEBUG(
+                "Stopping building at depth {} as {}", tree_t::get_depth(loc), reason);
+            tree[loc] = make_leaf<leaf_t>(counts);
+            return;
+        }
+
+        node_type split = find_best_split(last - first, samples.features.size(),
+            [this, &samples, &node_samples, &counts](std::size_t index) {
+                const auto& [feature_id, feature] = samples.features[index];
+                const auto& labels_ = samples.labels_;
+                auto data = node_samples(index)
+                    | std::views::transform([feature, &labels_](std::size_t i) {
+                          return std::pair<double, typename labels_t::label_t> {
+                              (*feature)[i], labels_[i]
+                          };
+                      });
+
+                auto [cost, splitting] = m_algo.split_sorted(data, counts, m_cost_fn);
+                return split_candidate { cost, { feature_id, splitting } };
+            });
+        SPDLOG_DEBUG("Best split found at depth {} on feature {}",
+            tree_t::get_depth(loc), split.feature_id_);
+        tree[loc] = split;
+
+        const auto& best_feature = *std::ranges::find(samples.features,
+            split.feature_id_, &std::pair<feature_id, const feature_t*>::first)->second;
+        for (std::size_t i : node_samples(0)) {
+            samples.lower[i] = split.splitting(best_feature[i]);
+        }
+
+        std::size_t middle = first;
+        for (auto& order : samples.orders) {
+            auto it = std::stable_partition(begin(order) + first, begin(order) + last,
+                [&samples](std::size_t i) { return samples.lower[i]; });
+            middle = it - begin(order);
+        }
+
+        build_sub_trees(
+            last - first,
+            [this, &tree, &samples, loc, first, middle]() {
+                build_presorted(tree, tree_t::next(true, loc), samples, first, middle);
+            },
+            [this, &tree, &samples, loc, middle, last]() {
+                build_presorted(tree, tree_t::next(false, loc), samples, middle, last);
+            });
+    }
+
+    template <typename feature_set, typename labels_t>
+    void build_in_place(
+        tree_t& tree, const feature_set& features, const labels_t& labels_) const
+    {
+        std::vector<std::size_t> index(labels_.size());
+        std::iota(begin(index), end(index), 0u);
+
+        build_in_place(tree, 0u, features, labels_, std::span { index });
+    }
+
+    /// Builds the sub tree at loc from the samples at the locations in index. Splitting
+    /// the node stably partitions index into the samples of the two children, so every
+    /// node works on its own contiguous slice of the one buffer of indices and the
+    /// indices of a node stay in increasing order.
+    template <typename feature_set, typename labels_t>
+    void build_in_place(tree_t& tree, std::size_t loc, const feature_set& features,
+        const labels_t& labels_, std::span<std::size_t> index) const
+    {
+        labels_view<labels_t> node_labels { labels_, index };
+
+        if (auto reason = should_stop(m_config, tree_t::get_depth(loc),
+                node_labels.get_label_counts(), node_labels.size())) {
+            SPDLOG_DEBUG(
+                "Stopping building at depth {} as {}", tree_t::get_depth(loc), reason);
+            tree[loc] = make_leaf<leaf_t>(node_labels.get_label_counts());
+            return;
+        }
+
+        // as the partitions are stable a node holding every sample has them in order,
+        // so the algos get the features themselves, e.g. the contiguous columns of a
+        // dataset, rather than views through the index
+        node_type split = index.size() == labels_.size()
+            ? find_split(features, labels_)
+            : find_split(features, node_labels, index);
+        SPDLOG_DEBUG("Best split found at depth {} on feature {}",
+            tree_t::get_depth(loc), split.feature_id_);
+        tree[loc] = split;
+
+        auto middle = partition_index(features.find(split.feature_id_)->second, split,
+            begin(index), end(index));
+        std::size_t n_lower = middle - begin(index);
+
+        build_sub_trees(
+            index.size(),
+            [this, &tree, &features, &labels_, index, n_lower, loc]() {
+                build_in_place(tree, tree_t::next(true, loc), features, labels_,
+                    index.first(n_lower));
+            },
+            [this, &tree, &features, &labels_, index, n_lower, loc]() {
+                build_in_place(tree, tree_t::next(false, loc), features, labels_,
+                    index.subspan(n_lower));
+            });
+    }
+
+    template <typename feature_t, typename iterator_t>
+    iterator_t partition_index(const feature_t& feature, const node_type& node,
+        iterator_t first, iterator_t last) const
+    {
+        return std::stable_partition(first, last,
+            [&feature, &node](std::size_t i) { return node.splitting(feature[i]); });
+    }
+
+    template <mixed_feature_c feature_t, typename iterator_t>
+    iterator_t partition_index(const feature_t& feature, const node_type& node,
+        iterator_t first, iterator_t last) const
+    {
+        return std::visit(
+            [this, &node, first, last](
+                const auto& f) { return partition_index(f, node, first, last); },
+            feature);
     }
 
     tree_builder_config m_config;
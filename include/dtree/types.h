@@ -1,12 +1,23 @@
 #pragma once
 
 #include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace dtree {
 
 using feature_id = std::size_t;
 
+/// category
+///
+/// A sample of a categorical feature, the dense code of its category (see
+/// dtree::category_dictionary). It is its own type rather than an integer so that
+/// categorical features are never split as numbers.
+struct category {
+    bool operator==(const category&) const = default;
+    std::uint32_t code;
+};
+
 template <typename splitting_t> struct node {
     bool operator==(const node&) const = default;
     feature_id feature_id_;
@@ -14,12 +25,31 @@ template <typename splitting_t> struct node {
 };
 
 // Tree types
-template <typename node_type> class flat_tree;
+class leaf;
+class binary_leaf;
+
+template <typename node_type, typename leaf_t = leaf> class flat_tree;
+template <typename node_type, typename leaf_t = leaf> class compact_tree;
+template <typename leaf_t = leaf> class packed_tree;
+
+// The leaves of the trees an algo builds. An algo specialised to two classes (one
+// with a static n_classes of 2) only needs the probability of the second.
+template <typename algo_t> struct leaf_type {
+    using type = leaf;
+};
+
+template <typename algo_t>
+requires(algo_t::n_classes == 2) struct leaf_type<algo_t> {
+    using type = binary_leaf;
+};
+
+template <typename algo_t> using leaf_type_t = leaf_type<algo_t>::type;
 
 // This helper class allows us to define the concrete tree type
 // by the algorithm type that will be used to build it.
 template <typename algo_t>
-using flat_tree_t = flat_tree<node<typename algo_t::splitting_type>>;
+using flat_tree_t
+    = flat_tree<node<typename algo_t::splitting_type>, leaf_type_t<algo_t>>;
 
 using label_counts = std::vector<std::size_t>;
 
@@ -0,0 +1,103 @@
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "dtree/aho_corasick.h"
+
+namespace dtree {
+
+namespace {
+
+    struct trie_node {
+        std::vector<std::pair<unsigned char, std::uint32_t>> children;
+        std::uint32_t pattern = aho_corasick::no_pattern;
+    };
+
+    std::uint32_t find_child(const trie_node& node, unsigned char c)
+    {
+        for (auto [child_c, child] : node.children) {
+            if (child_c == c)
+                return child;
+        }
+        return 0u;
+    }
+
+} // namespace
+
+aho_corasick::aho_corasick(const std::vector<std::string>& patterns)
+    : m_patterns {}
+    , m_root {}
+    , m_edges_begin {}
+    , m_edge_chars {}
+    , m_edge_targets {}
+    , m_fail {}
+    , m_output_link {}
+    , m_pattern {}
+{
+    std::vector<trie_node> trie(1);
+
+    std::unordered_set<std::string_view> seen;
+    for (const auto& pattern : patterns) {
+        if (!seen.insert(pattern).second)
+            continue;
+
+        std::uint32_t node = 0;
+        for (unsigned char c : pattern) {
+            std::uint32_t child = find_child(trie[node], c);
+            if (child == 0) {
+                child = static_cast<std::uint32_t>(trie.size());
+                trie[node].children.emplace_back(c, child);
+                trie.emplace_back();
+            }
+            node = child;
+        }
+        trie[node].pattern = static_cast<std::uint32_t>(m_patterns.size());
+        m_patterns.push_back(pattern);
+    }
+
+    // renumber the states breadth first, so the failure links of a state's children
+    // can be found from states already numbered and a scan mostly stays near the root
+    std::vector<std::uint32_t> order { 0u };
+    std::vector<std::uint32_t> ids(trie.size(), 0u);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        auto& children = trie[order[i]].children;
+        std::sort(begin(children), end(children));
+        for (auto [c, child] : children) {
+            ids[child] = static_cast<std::uint32_t>(order.size());
+            order.push_back(child);
+        }
+    }
+
+    std::size_t n_states = order.size();
+    m_edges_begin.reserve(n_states + 1);
+    m_edge_chars.reserve(n_states - 1);
+    m_edge_targets.reserve(n_states - 1);
+    m_pattern.reserve(n_states);
+    for (std::uint32_t node : order) {
+        m_edges_begin.push_back(static_cast<std::uint32_t>(m_edge_chars.size()));
+        for (auto [c, child] : trie[node].children) {
+            m_edge_chars.push_back(c);
+            m_edge_targets.push_back(ids[child]);
+        }
+        m_pattern.push_back(trie[node].pattern);
+    }
+    m_edges_begin.push_back(static_cast<std::uint32_t>(m_edge_chars.size()));
+
+    for (std::uint32_t e = m_edges_begin[0]; e < m_edges_begin[1]; ++e)
+        m_root[m_edge_chars[e]] = m_edge_targets[e];
+
+    m_fail.assign(n_states, 0u);
+    m_output_link.assign(n_states, 0u);
+    for (std::uint32_t state = 0; state < n_states; ++state) {
+        for (std::uint32_t e = m_edges_begin[state]; e < m_edges_begin[state + 1]; ++e) {
+            std::uint32_t child = m_edge_targets[e];
+            std::uint32_t fail = state == 0 ? 0u : next(m_fail[state], m_edge_chars[e]);
+
+            m_fail[child] = fail;
+            m_output_link[child]
+                = m_pattern[fail] != no_pattern ? fail : m_output_link[fail];
+        }
+    }
+}
+
+} // namespace dtree
@@ -9,22 +9,41 @@ constexpr double epsilon = 1e-8;
 
 std::vector<double> generate_random_normal(std::size_t n_features, unsigned int seed)
 {
-    std::vector<double> normal(n_features, 0.0);
-
     std::mt19937 gen { seed == 0 ? std::random_device {}() : seed };
+    return generate_random_normals(1u, n_features, gen);
+}
+
+std::vector<double> generate_random_normals(
+    std::size_t n_projections, std::size_t n_features, std::mt19937& gen)
+{
+    std::vector<double> normals(n_projections * n_features, 0.0);
 
     std::normal_distribution<double> dist;
 
-    bool all_zero = true;
-    while (all_zero) {
-        all_zero = true;
-        for (std::size_t i = 0; i < n_features; ++i) {
-            normal[i] = dist(gen);
-            all_zero &= std::abs(normal[i]) < epsilon;
+    for (std::size_t p = 0; p < n_projections; ++p) {
+        double* normal = normals.data() + p * n_features;
+
+        bool all_zero = true;
+        while (all_zero) {
+            all_zero = true;
+            for (std::size_t i = 0; i < n_features; ++i) {
+                normal[i] = dist(gen);
+                all_zero &= std::abs(normal[i]) < epsilon;
+            }
         }
     }
 
-    return normal;
+    return normals;
+}
+
+std::mt19937 make_generator(unsigned int seed, std::size_t key)
+{
+    if (seed == 0)
+        return std::mt19937 { std::random_device {}() };
+
+    std::seed_seq seq { seed, static_cast<unsigned int>(key),
+        static_cast<unsigned int>(key >> 32) };
+    return std::mt19937 { seq };
 }
 
 } // dtree::algos
@@ -0,0 +1,92 @@
+
+#include <algorithm>
+#include <cstdint>
+
+#include "dtree/arena.h"
+
+namespace dtree {
+
+namespace {
+
+    // blocks come from upstream with the largest alignment anything is allocated with
+    constexpr std::size_t block_alignment = alignof(std::max_align_t);
+
+    std::size_t aligned_offset(
+        const std::byte* data, std::size_t offset, std::size_t alignment)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(data) + offset;
+        return (address + alignment - 1) / alignment * alignment
+            - reinterpret_cast<std::uintptr_t>(data);
+    }
+
+} // namespace
+
+arena_resource::arena_resource(
+    std::size_t block_size, std::pmr::memory_resource* upstream)
+    : m_block_size { block_size }
+    , m_upstream { upstream }
+    , m_blocks {}
+    , m_current { 0u }
+    , m_offset { 0u }
+{
+}
+
+arena_resource::~arena_resource()
+{
+    for (const auto& b : m_blocks) {
+        m_upstream->deallocate(b.data, b.size, block_alignment);
+    }
+}
+
+void arena_resource::rewind(marker mark)
+{
+    m_current = mark.block;
+    m_offset = mark.offset;
+}
+
+std::size_t arena_resource::capacity() const
+{
+    std::size_t total = 0u;
+    for (const auto& b : m_blocks)
+        total += b.size;
+    return total;
+}
+
+void* arena_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    auto fits = [bytes, alignment](const block& b, std::size_t offset) {
+        return aligned_offset(b.data, offset, alignment) + bytes <= b.size;
+    };
+
+    // move on through the blocks already held, and when none is left that fits add
+    // one after the current block, so the blocks before a mark are never touched
+    if (m_current < m_blocks.size() && !fits(m_blocks[m_current], m_offset)) {
+        ++m_current;
+        m_offset = 0u;
+    }
+    while (m_current < m_blocks.size() && !fits(m_blocks[m_current], 0u)) {
+        m_upstream->deallocate(
+            m_blocks[m_current].data, m_blocks[m_current].size, block_alignment);
+        m_blocks.erase(m_blocks.begin() + m_current);
+    }
+    if (m_current == m_blocks.size()) {
+        std::size_t size = std::max(m_block_size, bytes + alignment);
+        m_blocks.push_back({ static_cast<std::byte*>(
+                                 m_upstream->allocate(size, block_alignment)),
+            size });
+        m_offset = 0u;
+    }
+
+    auto& current = m_blocks[m_current];
+    std::size_t offset = aligned_offset(current.data, m_offset, alignment);
+    m_offset = offset + bytes;
+    return current.data + offset;
+}
+
+arena_resource& scratch_arena()
+{
+    thread_local arena_resource arena {};
+    return arena;
+}
+
+} // namespace dtree
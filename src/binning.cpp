@@ -0,0 +1,45 @@
+
+#include <algorithm>
+
+#include "dtree/binning.h"
+
+namespace dtree {
+
+std::vector<double> quantile_edges(
+    const std::vector<double>& sorted_values, std::size_t max_bins)
+{
+    std::vector<double> edges;
+
+    std::size_t n = sorted_values.size();
+    if (n == 0 || max_bins == 0)
+        return edges;
+
+    std::size_t n_distinct = 1;
+    for (std::size_t i = 1; i < n; ++i) {
+        n_distinct += sorted_values[i] != sorted_values[i - 1];
+    }
+
+    for (std::size_t i = 0; i < n;) {
+        auto run_end = std::upper_bound(
+            begin(sorted_values) + i, end(sorted_values), sorted_values[i]);
+        std::size_t j = run_end - begin(sorted_values);
+
+        if (j == n) {
+            edges.push_back(sorted_values[i]);
+            break;
+        }
+
+        // close the bin once it holds its share of the samples, leaving room for
+        // the final bin
+        std::size_t target = (edges.size() + 1) * n / max_bins;
+        if (edges.size() + 1 < max_bins && (n_distinct <= max_bins || j >= target)) {
+            edges.push_back(0.5 * (sorted_values[j - 1] + sorted_values[j]));
+        }
+
+        i = j;
+    }
+
+    return edges;
+}
+
+} // namespace dtree
@@ -0,0 +1,23 @@
+
+#include "dtree/categorical.h"
+
+namespace dtree {
+
+std::uint32_t category_dictionary::intern(std::string_view string)
+{
+    if (auto it = m_codes.find(string); it != m_codes.end())
+        return it->second;
+
+    auto code = static_cast<std::uint32_t>(m_strings.size());
+    m_strings.emplace_back(string);
+    m_codes.emplace(m_strings.back(), code);
+    return code;
+}
+
+std::uint32_t category_dictionary::find(std::string_view string) const
+{
+    auto it = m_codes.find(string);
+    return it == m_codes.end() ? unknown : it->second;
+}
+
+} // namespace dtree
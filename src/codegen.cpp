@@ -0,0 +1,55 @@
+
+#include <charconv>
+#include <cmath>
+#include <string_view>
+
+#include "dtree/codegen.h"
+
+namespace dtree {
+
+void write_literal(std::ostream& out, double value)
+{
+    if (std::isnan(value)) {
+        out << "std::numeric_limits<double>::quiet_NaN()";
+        return;
+    }
+    if (std::isinf(value)) {
+        out << (value < 0 ? "-" : "") << "std::numeric_limits<double>::infinity()";
+        return;
+    }
+
+    // the shortest digits that read back as the value, with a point so the literal
+    // is a double however few of them there are
+    char buffer[32];
+    auto [end, ec] = std::to_chars(std::begin(buffer), std::end(buffer), value);
+    std::string_view digits { buffer, end };
+    out << digits;
+    if (digits.find_first_of(".e") == std::string_view::npos)
+        out << ".0";
+}
+
+void write_cpp_prologue(
+    std::ostream& out, const codegen_config& config, std::string_view return_type)
+{
+    out << "// Generated by dtree::write_cpp, do not edit.\n"
+        << "#pragma once\n"
+        << "\n"
+        << "#include <array>\n"
+        << "#include <limits>\n"
+        << "\n"
+        << "namespace " << config.namespace_name << " {\n"
+        << "\n"
+        << "template <typename sample_t>\n"
+        << "constexpr " << return_type << " " << config.function_name
+        << "([[maybe_unused]] const sample_t& sample)\n"
+        << "{\n";
+}
+
+void write_cpp_epilogue(std::ostream& out, const codegen_config& config)
+{
+    out << "}\n"
+        << "\n"
+        << "} // namespace " << config.namespace_name << "\n";
+}
+
+} // namespace dtree
@@ -0,0 +1,182 @@
+#include <cstdint>
+#include <vector>
+
+#include "dtree/complete_tree.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DTREE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace dtree {
+
+namespace {
+
+    using find_leaves_fn = void (*)(const std::uint32_t*, const double*, std::size_t,
+        const double*, std::size_t, std::span<std::uint32_t>);
+
+    void find_leaves_scalar(const std::uint32_t* features, const double* thresholds,
+        std::size_t depth, const double* data, std::size_t stride,
+        std::span<std::uint32_t> slots)
+    {
+        std::size_t n_splits = (std::size_t { 1 } << depth) - 1;
+        for (std::size_t i = 0; i < slots.size(); ++i) {
+            std::size_t loc = 0;
+            for (std::size_t level = 0; level < depth; ++level) {
+                double x = data[features[loc] * stride + i];
+                loc = 2 * loc + 1 + !(x <= thresholds[loc]);
+            }
+            slots[i] = static_cast<std::uint32_t>(loc - n_splits);
+        }
+    }
+
+#ifdef DTREE_X86_KERNELS
+
+    // vectors of samples descending together, so the gathers of one overlap with the
+    // latency of the others'
+    constexpr int vectors_in_flight = 4;
+
+    // Each level gathers the feature and threshold of every lane's node, then the
+    // lane's value of that feature, and moves to 2 * loc + 2 less one where x <= t
+    // (the compare gives -1 there). The offsets of the values are formed with a 32 bit
+    // multiply, so the stride of a batch must be below 2^32.
+    __attribute__((target("avx2"))) void find_leaves_avx2(
+        const std::uint32_t* features, const double* thresholds, std::size_t depth,
+        const double* data, std::size_t stride, std::span<std::uint32_t> slots)
+    {
+        const auto* feature_base = reinterpret_cast<const int*>(features);
+        const __m256i strides = _mm256_set1_epi64x(static_cast<long long>(stride));
+        const __m256i twos = _mm256_set1_epi64x(2);
+        const __m256i lanes = _mm256_set_epi64x(3, 2, 1, 0);
+
+        std::size_t n = slots.size();
+        std::size_t i = 0;
+        for (; i + 4 * vectors_in_flight <= n; i += 4 * vectors_in_flight) {
+            __m256i samples[vectors_in_flight];
+            __m256i locs[vectors_in_flight];
+            for (int v = 0; v < vectors_in_flight; ++v) {
+                auto first = static_cast<long long>(i + 4 * v);
+                samples[v] = _mm256_add_epi64(_mm256_set1_epi64x(first), lanes);
+                locs[v] = _mm256_setzero_si256();
+            }
+            for (std::size_t level = 0; level < depth; ++level) {
+                for (int v = 0; v < vectors_in_flight; ++v) {
+                    __m256i feature = _mm256_cvtepu32_epi64(
+                        _mm256_i64gather_epi32(feature_base, locs[v], 4));
+                    __m256d threshold = _mm256_i64gather_pd(thresholds, locs[v], 8);
+                    __m256i offset = _mm256_add_epi64(
+                        _mm256_mul_epu32(feature, strides), samples[v]);
+                    __m256d x = _mm256_i64gather_pd(data, offset, 8);
+                    __m256i lower
+                        = _mm256_castpd_si256(_mm256_cmp_pd(x, threshold, _CMP_LE_OQ));
+                    locs[v] = _mm256_add_epi64(
+                        _mm256_add_epi64(_mm256_slli_epi64(locs[v], 1), twos), lower);
+                }
+            }
+            for (int v = 0; v < vectors_in_flight; ++v) {
+                alignas(32) std::int64_t out[4];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(out), locs[v]);
+                for (int lane = 0; lane < 4; ++lane) {
+                    slots[i + 4 * v + lane] = static_cast<std::uint32_t>(
+                        out[lane] - ((std::int64_t { 1 } << depth) - 1));
+                }
+            }
+        }
+
+        find_leaves_scalar(
+            features, thresholds, depth, data + i, stride, slots.subspan(i));
+    }
+
+    // GCC 12 reports the _mm512_undefined its AVX-512 gathers and conversions start
+    // from as uninitialized
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    __attribute__((target("avx512f"))) void find_leaves_avx512(
+        const std::uint32_t* features, const double* thresholds, std::size_t depth,
+        const double* data, std::size_t stride, std::span<std::uint32_t> slots)
+    {
+        const __m512i strides = _mm512_set1_epi64(static_cast<long long>(stride));
+        const __m512i twos = _mm512_set1_epi64(2);
+        const __m512i lanes = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+
+        std::size_t n = slots.size();
+        std::size_t i = 0;
+        for (; i + 8 * vectors_in_flight <= n; i += 8 * vectors_in_flight) {
+            __m512i samples[vectors_in_flight];
+            __m512i locs[vectors_in_flight];
+            for (int v = 0; v < vectors_in_flight; ++v) {
+                auto first = static_cast<long long>(i + 8 * v);
+                samples[v] = _mm512_add_epi64(_mm512_set1_epi64(first), lanes);
+                locs[v] = _mm512_setzero_si512();
+            }
+            for (std::size_t level = 0; level < depth; ++level) {
+                for (int v = 0; v < vectors_in_flight; ++v) {
+                    __m512i feature = _mm512_cvtepu32_epi64(
+                        _mm512_i64gather_epi32(locs[v], features, 4));
+                    __m512d threshold = _mm512_i64gather_pd(locs[v], thresholds, 8);
+                    __m512i offset = _mm512_add_epi64(
+                        _mm512_mul_epu32(feature, strides), samples[v]);
+                    __m512d x = _mm512_i64gather_pd(offset, data, 8);
+                    __mmask8 lower = _mm512_cmp_pd_mask(x, threshold, _CMP_LE_OQ);
+                    __m512i next
+                        = _mm512_add_epi64(_mm512_slli_epi64(locs[v], 1), twos);
+                    locs[v] = _mm512_mask_sub_epi64(
+                        next, lower, next, _mm512_set1_epi64(1));
+                }
+            }
+            for (int v = 0; v < vectors_in_flight; ++v) {
+                __m512i first = _mm512_set1_epi64((std::int64_t { 1 } << depth) - 1);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(slots.data() + i + 8 * v),
+                    _mm512_cvtepi64_epi32(_mm512_sub_epi64(locs[v], first)));
+            }
+        }
+
+        find_leaves_scalar(
+            features, thresholds, depth, data + i, stride, slots.subspan(i));
+    }
+
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+    /// The widest kernel the cpu running the process supports.
+    find_leaves_fn select_kernel()
+    {
+        static const find_leaves_fn selected
+            = supported_complete_leaves_kernels().front().find_leaves;
+        return selected;
+    }
+
+} // namespace
+
+std::span<const complete_leaves_kernel> supported_complete_leaves_kernels()
+{
+    static const std::vector<complete_leaves_kernel> supported = []() {
+        std::vector<complete_leaves_kernel> out;
+#ifdef DTREE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+            out.push_back({ "avx512", find_leaves_avx512 });
+        if (__builtin_cpu_supports("avx2"))
+            out.push_back({ "avx2", find_leaves_avx2 });
+#endif
+        out.push_back({ "scalar", find_leaves_scalar });
+        return out;
+    }();
+    return supported;
+}
+
+void find_complete_leaves(const std::uint32_t* features, const double* thresholds,
+    std::size_t depth, const double* data, std::size_t stride,
+    std::span<std::uint32_t> slots)
+{
+    select_kernel()(features, thresholds, depth, data, stride, slots);
+}
+
+} // namespace dtree
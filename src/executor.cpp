@@ -0,0 +1,211 @@
+
+#include <algorithm>
+#include <exception>
+
+#include "dtree/executor.h"
+
+namespace dtree {
+
+namespace {
+
+    thread_local const work_stealing_pool* current_pool = nullptr;
+
+    thread_local std::size_t current_queue = 0;
+
+} // namespace
+
+void executor::parallel_for(std::size_t n, const std::function<void(std::size_t)>& fn)
+{
+    parallel_for(0u, n, fn);
+}
+
+void executor::parallel_for(
+    std::size_t first, std::size_t last, const std::function<void(std::size_t)>& fn)
+{
+    if (last - first <= 1) {
+        if (first < last)
+            fn(first);
+        return;
+    }
+
+    std::size_t middle = first + (last - first) / 2;
+    invoke([this, first, middle, &fn]() { parallel_for(first, middle, fn); },
+        [this, middle, last, &fn]() { parallel_for(middle, last, fn); });
+}
+
+struct work_stealing_pool::task {
+    void run()
+    {
+        try {
+            (*fn)();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        done.store(true, std::memory_order_release);
+    }
+
+    const std::function<void()>* fn;
+    std::atomic<bool> done { false };
+    std::exception_ptr error {};
+};
+
+work_stealing_pool::work_stealing_pool(std::size_t n_threads)
+    : m_queues {}
+    , m_pending { 0u }
+    , m_stop { false }
+    , m_mutex {}
+    , m_wake {}
+    , m_threads {}
+{
+    n_threads = std::max<std::size_t>(n_threads, 1u);
+
+    // one queue per worker and a last one shared by threads outside the pool
+    for (std::size_t i = 0; i <= n_threads; ++i) {
+        m_queues.push_back(std::make_unique<task_queue>());
+    }
+
+    m_threads.reserve(n_threads);
+    for (std::size_t i = 0; i < n_threads; ++i) {
+        m_threads.emplace_back([this, i]() { run_worker(i); });
+    }
+}
+
+work_stealing_pool::~work_stealing_pool()
+{
+    {
+        std::lock_guard lock { m_mutex };
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void work_stealing_pool::invoke(
+    const std::function<void()>& lower, const std::function<void()>& upper)
+{
+    std::size_t index = queue_index();
+
+    task upper_task { &upper };
+    push(index, &upper_task);
+
+    std::exception_ptr lower_error;
+    try {
+        lower();
+    } catch (...) {
+        lower_error = std::current_exception();
+    }
+
+    if (reclaim(index, &upper_task)) {
+        upper_task.run();
+    } else {
+        while (!upper_task.done.load(std::memory_order_acquire)) {
+            if (!run_one(index))
+                std::this_thread::yield();
+        }
+    }
+
+    if (lower_error)
+        std::rethrow_exception(lower_error);
+    if (upper_task.error)
+        std::rethrow_exception(upper_task.error);
+}
+
+std::size_t work_stealing_pool::queue_index() const
+{
+    return current_pool == this ? current_queue : m_threads.size();
+}
+
+void work_stealing_pool::push(std::size_t index, task* t)
+{
+    {
+        std::lock_guard lock { m_queues[index]->mutex };
+        m_queues[index]->tasks.push_back(t);
+    }
+    m_pending.fetch_add(1u, std::memory_order_release);
+
+    // taking the lock means a worker that has just found nothing to do is either
+    // already waiting or will see the new task when it checks again
+    { std::lock_guard lock { m_mutex }; }
+    m_wake.notify_one();
+}
+
+bool work_stealing_pool::reclaim(std::size_t index, task* t)
+{
+    auto& queue = *m_queues[index];
+    std::lock_guard lock { queue.mutex };
+
+    // nested invokes have either reclaimed their tasks or waited for them, so unless
+    // it was stolen the task is at the back of a worker's queue. The shared queue can
+    // have tasks from other threads on top of it.
+    auto it = std::find(queue.tasks.rbegin(), queue.tasks.rend(), t);
+    if (it == queue.tasks.rend())
+        return false;
+
+    queue.tasks.erase(std::next(it).base());
+    m_pending.fetch_sub(1u, std::memory_order_relaxed);
+    return true;
+}
+
+work_stealing_pool::task* work_stealing_pool::pop(std::size_t index)
+{
+    auto& queue = *m_queues[index];
+    std::lock_guard lock { queue.mutex };
+    if (queue.tasks.empty())
+        return nullptr;
+
+    task* t = queue.tasks.back();
+    queue.tasks.pop_back();
+    m_pending.fetch_sub(1u, std::memory_order_relaxed);
+    return t;
+}
+
+work_stealing_pool::task* work_stealing_pool::steal(std::size_t index)
+{
+    for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+        auto& queue = *m_queues[(index + offset) % m_queues.size()];
+        std::lock_guard lock { queue.mutex };
+        if (queue.tasks.empty())
+            continue;
+
+        task* t = queue.tasks.front();
+        queue.tasks.pop_front();
+        m_pending.fetch_sub(1u, std::memory_order_relaxed);
+        return t;
+    }
+    return nullptr;
+}
+
+bool work_stealing_pool::run_one(std::size_t index)
+{
+    task* t = pop(index);
+    if (t == nullptr)
+        t = steal(index);
+    if (t == nullptr)
+        return false;
+
+    t->run();
+    return true;
+}
+
+void work_stealing_pool::run_worker(std::size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        if (run_one(index))
+            continue;
+
+        std::unique_lock lock { m_mutex };
+        m_wake.wait(lock, [this]() {
+            return m_stop || m_pending.load(std::memory_order_acquire) > 0;
+        });
+        if (m_stop)
+            return;
+    }
+}
+
+} // namespace dtree
@@ -1,35 +1,577 @@
-
+#include <array>
+#include <bit>
 #include <cmath>
-#include <numeric>
+#include <cstdint>
+#include <numbers>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DTREE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
 
 #include "dtree/impurity_measures.h"
 
 namespace dtree {
 
-double gini_index(const label_counts& label_counts)
+namespace {
+
+    /// x log2(x) to about twice double precision, as the nearest double and the
+    /// remainder. Used to fill the tables, long double giving the extra bits where it
+    /// is wider than double.
+    std::pair<double, double> x_log2_x_long_double(long double x)
+    {
+        auto y = x * std::log2(x);
+        auto hi = static_cast<double>(y);
+        return { hi, static_cast<double>(y - hi) };
+    }
+
+    // c log2(c) of the small counts, which are most of the counts below the root, as
+    // the pairs of x_log2_x_long_double side by side so that both halves of a count
+    // are on one cache line, and log2(q) of the leading bits q of a larger count (see
+    // split_c_log2_c) as two tables
+    constexpr std::size_t c_log2_c_table_size = 2048;
+    constexpr std::size_t log2_table_bits = 11;
+    constexpr std::size_t log2_table_first = std::size_t { 1 } << (log2_table_bits - 1);
+
+    struct c_log2_c_table_t {
+        alignas(64) std::array<double, 2 * c_log2_c_table_size> c_log2_c;
+        std::array<double, log2_table_first> log2_hi;
+        std::array<double, log2_table_first> log2_lo;
+    };
+
+    const c_log2_c_table_t& c_log2_c_table()
+    {
+        static const auto table = []() {
+            c_log2_c_table_t out {};
+            for (std::size_t c = 2; c < c_log2_c_table_size; ++c)
+                std::tie(out.c_log2_c[2 * c], out.c_log2_c[2 * c + 1])
+                    = x_log2_x_long_double(c);
+            for (std::size_t i = 0; i < log2_table_first; ++i) {
+                auto q = static_cast<long double>(log2_table_first + i);
+                auto y = std::log2(q);
+                out.log2_hi[i] = static_cast<double>(y);
+                out.log2_lo[i] = static_cast<double>(y - out.log2_hi[i]);
+            }
+            return out;
+        }();
+        return table;
+    }
+
+    /// a + b as the nearest double and its rounding error.
+    inline std::pair<double, double> two_sum(double a, double b)
+    {
+        double sum = a + b;
+        double rounded = sum - a;
+        return { sum, (a - (sum - rounded)) + (b - rounded) };
+    }
+
+    /// two_sum of an a whose magnitude is at least that of b, in fewer operations.
+    inline std::pair<double, double> fast_two_sum(double a, double b)
+    {
+        double sum = a + b;
+        return { sum, b - (sum - a) };
+    }
+
+    // (-1)^k / (k + 1), the coefficients of ln(1 + t) / t
+    constexpr std::array<double, 7> ln_1_t_series { 1.0, -1.0 / 2, 1.0 / 3, -1.0 / 4,
+        1.0 / 5, -1.0 / 6, 1.0 / 7 };
+
+    /// ln(1 + t) from the first seven terms of its series. The polynomial is split as
+    /// (a + b t^2) + t^4 (c + k t^2), with a, b and c linear in t, so that it is not
+    /// one chain of dependent operations as Horner's scheme would be.
+    inline double ln_1_t(double t)
+    {
+        const auto& k = ln_1_t_series;
+        double t2 = t * t;
+        double a = k[0] + k[1] * t;
+        double b = k[2] + k[3] * t;
+        double c = k[4] + k[5] * t;
+        double p = (a + b * t2) + (t2 * t2) * (c + k[6] * t2);
+        return t * p;
+    }
+
+    /// split_c_log2_c of a count past the table, which is q 2^shift (1 + t) with q its
+    /// leading log2_table_bits bits, so log2(c) is shift + log2(q), from the table,
+    /// plus log2(1 + t). As t is below 2^-10 seven terms of the series of ln(1 + t)
+    /// leave an error below 2^-83, far below what is kept.
+    inline std::pair<double, double> split_large_c_log2_c(
+        const c_log2_c_table_t& table, std::size_t c)
+    {
+        int shift = std::bit_width(c) - static_cast<int>(log2_table_bits);
+        std::size_t q = c >> shift;
+        std::size_t base = q << shift;
+        double t = static_cast<double>(c - base) / static_cast<double>(base);
+
+        auto [log2_hi, error]
+            = two_sum(static_cast<double>(shift), table.log2_hi[q - log2_table_first]);
+        double log2_lo = error + table.log2_lo[q - log2_table_first]
+            + ln_1_t(t) * std::numbers::log2e;
+
+        // x log2_hi and its error do not wait for t, and as lo is far below hi its sum
+        // with hi needs no more than a fast_two_sum
+        double x = static_cast<double>(c);
+        double hi = x * log2_hi;
+        return fast_two_sum(hi, std::fma(x, log2_hi, -hi) + x * log2_lo);
+    }
+
+    /// c log2(c) to about twice double precision, as the nearest double and the
+    /// remainder.
+    inline std::pair<double, double> split_c_log2_c(
+        const c_log2_c_table_t& table, std::size_t c)
+    {
+        if (c >= c_log2_c_table_size)
+            return split_large_c_log2_c(table, c);
+        return { table.c_log2_c[2 * c], table.c_log2_c[2 * c + 1] };
+    }
+
+    /// Adds hi + lo to the sum, keeping the rounding error of the addition in the
+    /// compensation.
+    inline void add_compensated(count_sums& sums, double hi, double lo)
+    {
+        auto [sum, error] = two_sum(sums.sum, hi);
+        sums.compensation += error + lo;
+        sums.sum = sum;
+    }
+
+    count_sums sum_squares_scalar(const std::size_t* counts, std::size_t n)
+    {
+        count_sums out { 0u, 0.0 };
+        for (std::size_t i = 0; i < n; ++i) {
+            double c = static_cast<double>(counts[i]);
+            out.total += counts[i];
+            out.sum += c * c;
+        }
+        return out;
+    }
+
+    /// Also the tail of the wider kernels, which inline it so that its std::fma is an
+    /// instruction rather than a library call.
+    inline count_sums sum_c_log2_c_scalar(const std::size_t* counts, std::size_t n)
+    {
+        const auto& table = c_log2_c_table();
+        count_sums out { 0u, 0.0 };
+        for (std::size_t i = 0; i < n; ++i) {
+            out.total += counts[i];
+            auto [hi, lo] = split_c_log2_c(table, counts[i]);
+            add_compensated(out, hi, lo);
+        }
+        return out;
+    }
+
+#ifdef DTREE_X86_KERNELS
+
+    // AVX2 has no unsigned 64 bit to double conversion, but a count below 2^52 or'ed
+    // into the mantissa of 2^52 is exactly 2^52 + count
+    __attribute__((target("avx2"))) inline __m256d to_double_avx2(__m256i x)
+    {
+        const __m256i magic_bits = _mm256_set1_epi64x(0x4330000000000000);
+        const __m256d magic = _mm256_set1_pd(4503599627370496.0);
+        return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(x, magic_bits)), magic);
+    }
+
+    __attribute__((target("avx2"))) inline std::size_t horizontal_sum_avx2(__m256i x)
+    {
+        alignas(32) std::array<std::uint64_t, 4> lanes;
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), x);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    __attribute__((target("avx2"))) inline double horizontal_sum_avx2(__m256d x)
+    {
+        alignas(32) std::array<double, 4> lanes;
+        _mm256_store_pd(lanes.data(), x);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    __attribute__((target("avx2,fma"))) count_sums sum_squares_avx2(
+        const std::size_t* counts, std::size_t n)
+    {
+        __m256i total = _mm256_setzero_si256();
+        __m256d sum = _mm256_setzero_pd();
+
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts + i));
+            __m256d d = to_double_avx2(c);
+            total = _mm256_add_epi64(total, c);
+            sum = _mm256_fmadd_pd(d, d, sum);
+        }
+
+        auto tail = sum_squares_scalar(counts + i, n - i);
+        return { horizontal_sum_avx2(total) + tail.total,
+            horizontal_sum_avx2(sum) + tail.sum };
+    }
+
+    /// two_sum in each lane, returning the sum and leaving its rounding error in error.
+    __attribute__((target("avx2"))) inline __m256d two_sum_avx2(
+        __m256d a, __m256d b, __m256d& error)
+    {
+        __m256d sum = _mm256_add_pd(a, b);
+        __m256d rounded = _mm256_sub_pd(sum, a);
+        error = _mm256_add_pd(
+            _mm256_sub_pd(a, _mm256_sub_pd(sum, rounded)), _mm256_sub_pd(b, rounded));
+        return sum;
+    }
+
+    /// add_compensated in each lane.
+    __attribute__((target("avx2"))) inline void add_compensated_avx2(
+        __m256d& sum, __m256d& compensation, __m256d hi, __m256d lo)
+    {
+        __m256d error;
+        sum = two_sum_avx2(sum, hi, error);
+        compensation = _mm256_add_pd(compensation, _mm256_add_pd(error, lo));
+    }
+
+    /// Adds the lanes of a compensated sum to out, folding the upper half onto the
+    /// lower one so that only two lanes are added one after the other.
+    __attribute__((target("avx2"))) inline void add_lanes_avx2(
+        count_sums& out, __m256d sum, __m256d compensation)
+    {
+        __m128d low_sum = _mm256_castpd256_pd128(sum);
+        __m128d high_sum = _mm256_extractf128_pd(sum, 1);
+        __m128d new_sum = _mm_add_pd(low_sum, high_sum);
+        __m128d rounded = _mm_sub_pd(new_sum, low_sum);
+        __m128d error = _mm_add_pd(_mm_sub_pd(low_sum, _mm_sub_pd(new_sum, rounded)),
+            _mm_sub_pd(high_sum, rounded));
+        __m128d new_compensation = _mm_add_pd(
+            _mm_add_pd(_mm256_castpd256_pd128(compensation),
+                _mm256_extractf128_pd(compensation, 1)),
+            error);
+
+        alignas(16) std::array<double, 2> sums;
+        alignas(16) std::array<double, 2> compensations;
+        _mm_store_pd(sums.data(), new_sum);
+        _mm_store_pd(compensations.data(), new_compensation);
+        for (std::size_t lane = 0; lane < 2; ++lane)
+            add_compensated(out, sums[lane], compensations[lane]);
+    }
+
+    /// ln_1_t in each lane.
+    __attribute__((target("avx2,fma"))) inline __m256d ln_1_t_avx2(__m256d t)
+    {
+        const auto& k = ln_1_t_series;
+        __m256d t2 = _mm256_mul_pd(t, t);
+        __m256d a = _mm256_fmadd_pd(_mm256_set1_pd(k[1]), t, _mm256_set1_pd(k[0]));
+        __m256d b = _mm256_fmadd_pd(_mm256_set1_pd(k[3]), t, _mm256_set1_pd(k[2]));
+        __m256d c = _mm256_fmadd_pd(_mm256_set1_pd(k[5]), t, _mm256_set1_pd(k[4]));
+        c = _mm256_fmadd_pd(_mm256_set1_pd(k[6]), t2, c);
+        __m256d p = _mm256_fmadd_pd(_mm256_mul_pd(t2, t2), c, _mm256_fmadd_pd(b, t2, a));
+        return _mm256_mul_pd(t, p);
+    }
+
+    /// split_large_c_log2_c in each lane, the lanes below the table being read as the
+    /// first count past it. The leading bits q of a count are found from the exponent
+    /// of the count as a double, which is bit_width(c) - 1.
+    __attribute__((target("avx2,fma"))) inline void split_large_c_log2_c_avx2(
+        const c_log2_c_table_t& table, __m256i c, __m256d& hi, __m256d& lo)
+    {
+        const __m256i table_size = _mm256_set1_epi64x(c_log2_c_table_size);
+        c = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(table_size),
+            _mm256_castsi256_pd(c),
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(c, table_size))));
+
+        __m256d x = to_double_avx2(c);
+        __m256i shift = _mm256_sub_epi64(
+            _mm256_srli_epi64(_mm256_castpd_si256(x), 52),
+            _mm256_set1_epi64x(1023 + log2_table_bits - 1));
+        __m256i q = _mm256_srlv_epi64(c, shift);
+        __m256i base = _mm256_sllv_epi64(q, shift);
+        __m256d t = _mm256_div_pd(
+            to_double_avx2(_mm256_sub_epi64(c, base)), to_double_avx2(base));
+
+        __m256i entry = _mm256_sub_epi64(q, _mm256_set1_epi64x(log2_table_first));
+        __m256d table_hi = _mm256_i64gather_pd(table.log2_hi.data(), entry, 8);
+        __m256d table_lo = _mm256_i64gather_pd(table.log2_lo.data(), entry, 8);
+
+        __m256d error;
+        __m256d log2_hi = two_sum_avx2(to_double_avx2(shift), table_hi, error);
+        __m256d log2_lo = _mm256_fmadd_pd(ln_1_t_avx2(t),
+            _mm256_set1_pd(std::numbers::log2e), _mm256_add_pd(error, table_lo));
+
+        // the fast_two_sum of split_large_c_log2_c
+        __m256d product = _mm256_mul_pd(x, log2_hi);
+        __m256d remainder
+            = _mm256_fmadd_pd(x, log2_lo, _mm256_fmsub_pd(x, log2_hi, product));
+        hi = _mm256_add_pd(product, remainder);
+        lo = _mm256_sub_pd(remainder, _mm256_sub_pd(hi, product));
+    }
+
+    __attribute__((target("avx2,fma"))) count_sums sum_c_log2_c_avx2(
+        const std::size_t* counts, std::size_t n)
+    {
+        const auto& table = c_log2_c_table();
+        const __m256i last_entry = _mm256_set1_epi64x(c_log2_c_table_size - 1);
+        const double* pairs = table.c_log2_c.data();
+
+        __m256i total = _mm256_setzero_si256();
+        __m256d sum = _mm256_setzero_pd();
+        __m256d compensation = _mm256_setzero_pd();
+
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts + i));
+            total = _mm256_add_epi64(total, c);
+
+            // the counts are far below 2^63 so the signed compare is safe
+            __m256i large_lanes = _mm256_cmpgt_epi64(c, last_entry);
+
+            // a large count reads the zeros of entry 0 and is replaced below
+            __m256i entry = _mm256_slli_epi64(_mm256_andnot_si256(large_lanes, c), 1);
+            __m256d hi = _mm256_i64gather_pd(pairs, entry, 8);
+            __m256d lo = _mm256_i64gather_pd(pairs + 1, entry, 8);
+
+            if (!_mm256_testz_si256(large_lanes, large_lanes)) {
+                __m256d large_hi;
+                __m256d large_lo;
+                split_large_c_log2_c_avx2(table, c, large_hi, large_lo);
+                __m256d blend = _mm256_castsi256_pd(large_lanes);
+                hi = _mm256_blendv_pd(hi, large_hi, blend);
+                lo = _mm256_blendv_pd(lo, large_lo, blend);
+            }
+            add_compensated_avx2(sum, compensation, hi, lo);
+        }
+
+        auto out = sum_c_log2_c_scalar(counts + i, n - i);
+        if (i == 0)
+            return out;
+        out.total += horizontal_sum_avx2(total);
+        add_lanes_avx2(out, sum, compensation);
+        return out;
+    }
+
+    // the avx512fintrin.h of GCC 12 starts most intrinsics from an _mm512_undefined
+    // value, which -Wall reports as uninitialized wherever one is inlined
+#ifndef __clang__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+    __attribute__((target("avx512f,avx512dq"))) count_sums sum_squares_avx512(
+        const std::size_t* counts, std::size_t n)
+    {
+        __m512i total = _mm512_setzero_si512();
+        __m512d sum = _mm512_setzero_pd();
+
+        for (std::size_t i = 0; i < n; i += 8) {
+            __mmask8 lanes = n - i >= 8 ? 0xff : (1u << (n - i)) - 1;
+            __m512i c = _mm512_maskz_loadu_epi64(lanes, counts + i);
+            __m512d d = _mm512_cvtepu64_pd(c);
+            total = _mm512_add_epi64(total, c);
+            sum = _mm512_fmadd_pd(d, d, sum);
+        }
+
+        return { horizontal_sum_avx2(_mm256_add_epi64(_mm512_castsi512_si256(total),
+                     _mm512_extracti64x4_epi64(total, 1))),
+            horizontal_sum_avx2(_mm256_add_pd(
+                _mm512_castpd512_pd256(sum), _mm512_extractf64x4_pd(sum, 1))) };
+    }
+
+    /// two_sum in each lane, returning the sum and leaving its rounding error in error.
+    __attribute__((target("avx512f"))) inline __m512d two_sum_avx512(
+        __m512d a, __m512d b, __m512d& error)
+    {
+        __m512d sum = _mm512_add_pd(a, b);
+        __m512d rounded = _mm512_sub_pd(sum, a);
+        error = _mm512_add_pd(
+            _mm512_sub_pd(a, _mm512_sub_pd(sum, rounded)), _mm512_sub_pd(b, rounded));
+        return sum;
+    }
+
+    /// ln_1_t in each lane.
+    __attribute__((target("avx512f"))) inline __m512d ln_1_t_avx512(__m512d t)
+    {
+        const auto& k = ln_1_t_series;
+        __m512d t2 = _mm512_mul_pd(t, t);
+        __m512d a = _mm512_fmadd_pd(_mm512_set1_pd(k[1]), t, _mm512_set1_pd(k[0]));
+        __m512d b = _mm512_fmadd_pd(_mm512_set1_pd(k[3]), t, _mm512_set1_pd(k[2]));
+        __m512d c = _mm512_fmadd_pd(_mm512_set1_pd(k[5]), t, _mm512_set1_pd(k[4]));
+        c = _mm512_fmadd_pd(_mm512_set1_pd(k[6]), t2, c);
+        __m512d p = _mm512_fmadd_pd(_mm512_mul_pd(t2, t2), c, _mm512_fmadd_pd(b, t2, a));
+        return _mm512_mul_pd(t, p);
+    }
+
+    /// split_large_c_log2_c_avx2 over eight lanes.
+    __attribute__((target("avx512f,avx512dq"))) inline void split_large_c_log2_c_avx512(
+        const c_log2_c_table_t& table, __m512i c, __m512d& hi, __m512d& lo)
+    {
+        c = _mm512_max_epu64(c, _mm512_set1_epi64(c_log2_c_table_size));
+
+        __m512d x = _mm512_cvtepu64_pd(c);
+        __m512i shift = _mm512_sub_epi64(_mm512_srli_epi64(_mm512_castpd_si512(x), 52),
+            _mm512_set1_epi64(1023 + log2_table_bits - 1));
+        __m512i q = _mm512_srlv_epi64(c, shift);
+        __m512i base = _mm512_sllv_epi64(q, shift);
+        __m512d t = _mm512_div_pd(_mm512_cvtepu64_pd(_mm512_sub_epi64(c, base)),
+            _mm512_cvtepu64_pd(base));
+
+        __m512i entry = _mm512_sub_epi64(q, _mm512_set1_epi64(log2_table_first));
+        __m512d table_hi = _mm512_i64gather_pd(entry, table.log2_hi.data(), 8);
+        __m512d table_lo = _mm512_i64gather_pd(entry, table.log2_lo.data(), 8);
+
+        __m512d error;
+        __m512d log2_hi = two_sum_avx512(_mm512_cvtepi64_pd(shift), table_hi, error);
+        __m512d log2_lo = _mm512_fmadd_pd(ln_1_t_avx512(t),
+            _mm512_set1_pd(std::numbers::log2e), _mm512_add_pd(error, table_lo));
+
+        __m512d product = _mm512_mul_pd(x, log2_hi);
+        __m512d remainder
+            = _mm512_fmadd_pd(x, log2_lo, _mm512_fmsub_pd(x, log2_hi, product));
+        hi = _mm512_add_pd(product, remainder);
+        lo = _mm512_sub_pd(remainder, _mm512_sub_pd(hi, product));
+    }
+
+    __attribute__((target("avx512f,avx512dq"))) count_sums sum_c_log2_c_avx512(
+        const std::size_t* counts, std::size_t n)
+    {
+        const auto& table = c_log2_c_table();
+        const __m512i table_size = _mm512_set1_epi64(c_log2_c_table_size);
+        const double* pairs = table.c_log2_c.data();
+
+        __m512i total = _mm512_setzero_si512();
+        __m512d sum = _mm512_setzero_pd();
+        __m512d compensation = _mm512_setzero_pd();
+
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m512i c = _mm512_loadu_si512(counts + i);
+            total = _mm512_add_epi64(total, c);
+
+            __mmask8 large_lanes = _mm512_cmpge_epu64_mask(c, table_size);
+            __m512i entry = _mm512_slli_epi64(c, 1);
+            __m512d hi = _mm512_mask_i64gather_pd(
+                _mm512_setzero_pd(), ~large_lanes, entry, pairs, 8);
+            __m512d lo = _mm512_mask_i64gather_pd(
+                _mm512_setzero_pd(), ~large_lanes, entry, pairs + 1, 8);
+
+            if (large_lanes) {
+                __m512d large_hi;
+                __m512d large_lo;
+                split_large_c_log2_c_avx512(table, c, large_hi, large_lo);
+                hi = _mm512_mask_blend_pd(large_lanes, hi, large_hi);
+                lo = _mm512_mask_blend_pd(large_lanes, lo, large_lo);
+            }
+
+            // add_compensated in each lane
+            __m512d error;
+            sum = two_sum_avx512(sum, hi, error);
+            compensation = _mm512_add_pd(compensation, _mm512_add_pd(error, lo));
+        }
+
+        auto out = sum_c_log2_c_scalar(counts + i, n - i);
+        if (i == 0)
+            return out;
+
+        // folds the upper half of the lanes onto the lower one
+        __m256d half_sum = _mm512_castpd512_pd256(sum);
+        __m256d half_compensation = _mm512_castpd512_pd256(compensation);
+        add_compensated_avx2(half_sum, half_compensation,
+            _mm512_extractf64x4_pd(sum, 1), _mm512_extractf64x4_pd(compensation, 1));
+
+        out.total += horizontal_sum_avx2(_mm256_add_epi64(
+            _mm512_castsi512_si256(total), _mm512_extracti64x4_epi64(total, 1)));
+        add_lanes_avx2(out, half_sum, half_compensation);
+        return out;
+    }
+
+#ifndef __clang__
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+    /// The entropy of counts with the given sums, 0 when there are none.
+    double entropy_of(const count_sums& sums)
+    {
+        if (sums.total == 0)
+            return 0.0;
+
+        // n log2(n) - s cancels most of its bits when the entropy is small, both are
+        // taken to twice double precision so that what is left is still exact
+        auto [hi, lo] = split_c_log2_c(c_log2_c_table(), sums.total);
+        double total_count = sums.total;
+        return ((hi - sums.sum) + (lo - sums.compensation)) / total_count;
+    }
+
+    /// The widest kernels the cpu running the process supports.
+    const impurity_kernels& select_kernels()
+    {
+        static const impurity_kernels& selected = supported_impurity_kernels().front();
+        return selected;
+    }
+
+} // namespace
+
+std::span<const impurity_kernels> supported_impurity_kernels()
 {
-    double total_count = std::accumulate(begin(label_counts), end(label_counts), 0u);
+    static const std::vector<impurity_kernels> supported = []() {
+        std::vector<impurity_kernels> out;
+#ifdef DTREE_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+            out.push_back({ "avx512", sum_squares_avx512, sum_c_log2_c_avx512 });
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            out.push_back({ "avx2", sum_squares_avx2, sum_c_log2_c_avx2 });
+#endif
+        out.push_back({ "scalar", sum_squares_scalar, sum_c_log2_c_scalar });
+        return out;
+    }();
+    return supported;
+}
+
+double c_log2_c(std::size_t c)
+{
+    if (c < c_log2_c_table_size)
+        return c_log2_c_table().c_log2_c[2 * c];
+    return static_cast<double>(c) * std::log2(static_cast<double>(c));
+}
 
-    double neg_gini = std::accumulate(begin(label_counts), end(label_counts), 0.0,
-        [total_count](double g, auto count) {
-            double p = static_cast<double>(count) / total_count;
-            return g + p * p;
-        });
+double gini_index(const label_counts& label_counts)
+{
+    auto sums = select_kernels().sum_squares(label_counts.data(), label_counts.size());
+    if (sums.total == 0)
+        return 0.0;
 
-    return 1.0 - neg_gini;
+    double total_count = sums.total;
+    return 1.0 - sums.sum / (total_count * total_count);
 }
 
 double entropy(const label_counts& label_counts)
 {
-    double total_count = std::accumulate(begin(label_counts), end(label_counts), 0u);
+    return entropy_of(
+        select_kernels().sum_c_log2_c(label_counts.data(), label_counts.size()));
+}
+
+gini_impurity::accumulator::accumulator(label_counts counts)
+    : m_counts { std::move(counts) }
+    , m_total { 0u }
+    , m_sum_squares { 0u }
+{
+    for (std::size_t c : m_counts) {
+        m_total += c;
+        m_sum_squares += c * c;
+    }
+}
 
-    double entropy = std::accumulate(begin(label_counts), end(label_counts), 0.0,
-        [total_count](double e, auto count) {
-            double p = static_cast<double>(count) / total_count;
-            return p > 0 ? e - p * std::log2(p) : e;
-        });
+entropy_impurity::accumulator::accumulator(label_counts counts)
+    : m_counts { std::move(counts) }
+    , m_sums { select_kernels().sum_c_log2_c(m_counts.data(), m_counts.size()) }
+{
+}
 
-    return entropy;
+double entropy_impurity::accumulator::cost() const { return entropy_of(m_sums); }
+
+void entropy_impurity::accumulator::set_count(std::size_t& count, std::size_t c)
+{
+    const auto& table = c_log2_c_table();
+    auto [old_hi, old_lo] = split_c_log2_c(table, count);
+    auto [new_hi, new_lo] = split_c_log2_c(table, c);
+    add_compensated(m_sums, -old_hi, -old_lo);
+    add_compensated(m_sums, new_hi, new_lo);
+    count = c;
 }
 
 } // namespace dtree
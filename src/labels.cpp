@@ -1,18 +1,17 @@
 
+#include <numeric>
+
 #include "dtree/labels.h"
 
 namespace dtree {
 
-label_counts labels::count_labels(const std::vector<label_t>& labels)
+label_distribution calculate_distribution(const label_counts& counts)
 {
-    label_counts out;
-
-    for (auto label : labels) {
-        if (label >= out.size()) {
-            out.resize(label + 1, 0u);
-        }
+    label_distribution out(counts.size(), 0.0);
+    double total_count = std::accumulate(begin(counts), end(counts), 0.0);
 
-        out[label]++;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        out[i] = static_cast<double>(counts[i]) / total_count;
     }
 
     return out;
@@ -0,0 +1,71 @@
+
+#include "dtree/suffix_automaton.h"
+
+namespace dtree {
+
+suffix_automaton::suffix_automaton()
+    : m_states { { {}, no_state, 0u, 0u, 0u } }
+{
+}
+
+void suffix_automaton::add(std::string_view text, std::size_t id)
+{
+    std::uint32_t last = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+        last = extend(last, static_cast<unsigned char>(text[i]), id, i);
+}
+
+void suffix_automaton::set_next(
+    std::uint32_t state, unsigned char c, std::uint32_t target)
+{
+    for (auto& [edge_c, edge_target] : m_states[state].edges) {
+        if (edge_c == c) {
+            edge_target = target;
+            return;
+        }
+    }
+    m_states[state].edges.emplace_back(c, target);
+}
+
+// A copy of q holding only its substrings no longer than p's and one more character,
+// which takes over the transitions on c to q from p and its suffixes.
+std::uint32_t suffix_automaton::clone(std::uint32_t p, std::uint32_t q, unsigned char c)
+{
+    auto cloned = static_cast<std::uint32_t>(m_states.size());
+    state copy = m_states[q];
+    copy.length = m_states[p].length + 1;
+    m_states.push_back(std::move(copy));
+    m_states[q].link = cloned;
+
+    for (; p != no_state && next(p, c) == q; p = m_states[p].link)
+        set_next(p, c, cloned);
+    return cloned;
+}
+
+std::uint32_t suffix_automaton::extend(
+    std::uint32_t last, unsigned char c, std::size_t text, std::size_t end)
+{
+    // the prefix is already a substring of an earlier text
+    if (std::uint32_t q = next(last, c); q != no_state) {
+        if (m_states[last].length + 1 == m_states[q].length)
+            return q;
+        return clone(last, q, c);
+    }
+
+    auto current = static_cast<std::uint32_t>(m_states.size());
+    m_states.push_back({ {}, 0u, m_states[last].length + 1, text, end });
+
+    std::uint32_t p = last;
+    for (; p != no_state && next(p, c) == no_state; p = m_states[p].link)
+        set_next(p, c, current);
+
+    if (p != no_state) {
+        std::uint32_t q = next(p, c);
+        std::uint32_t link
+            = m_states[p].length + 1 == m_states[q].length ? q : clone(p, q, c);
+        m_states[current].link = link;
+    }
+    return current;
+}
+
+} // namespace dtree
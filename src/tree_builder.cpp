@@ -0,0 +1,23 @@
+
+#include <algorithm>
+
+#include "dtree/tree_builder.h"
+
+namespace dtree {
+
+int should_stop(const tree_builder_config& config, std::size_t current_depth,
+    const label_counts& counts, std::size_t n_samples)
+{
+    if (current_depth >= config.max_depth)
+        return 101;
+    if (n_samples <= config.min_samples)
+        return 102;
+
+    auto max_count = std::max_element(begin(counts), end(counts));
+    double max_p = static_cast<double>(*max_count) / n_samples;
+    if (max_p >= config.probability_limit)
+        return 103;
+    return 0;
+}
+
+} // namespace dtree
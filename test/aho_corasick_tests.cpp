@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include "dtree/aho_corasick.h"
+
+namespace {
+
+std::vector<std::uint32_t> find_patterns(
+    const dtree::aho_corasick& automaton, const std::string& text)
+{
+    std::vector<std::uint32_t> visited(automaton.number_of_states(), 0u);
+    std::vector<std::uint32_t> out;
+    automaton.for_each_pattern(
+        text, visited, 1u, [&out](std::uint32_t id) { out.push_back(id); });
+    std::sort(begin(out), end(out));
+    return out;
+}
+
+} // namespace
+
+TEST(test_aho_corasick, test_for_each_pattern)
+{
+    using ::testing::ElementsAre;
+
+    dtree::aho_corasick automaton { std::vector<std::string> {
+        "he", "she", "his", "hers", "he" } };
+
+    ASSERT_EQ(automaton.size(), 4u);
+    EXPECT_EQ(automaton[3], "hers");
+
+    // each pattern once, however often it occurs
+    EXPECT_THAT(find_patterns(automaton, "ushers"), ElementsAre(0u, 1u, 3u));
+    EXPECT_THAT(find_patterns(automaton, "hehehe"), ElementsAre(0u));
+    EXPECT_THAT(find_patterns(automaton, "this"), ElementsAre(2u));
+    EXPECT_TRUE(find_patterns(automaton, "").empty());
+    EXPECT_TRUE(find_patterns(automaton, "hs").empty());
+}
+
+TEST(test_aho_corasick, test_against_find)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<int> c_dist { 'a', 'd' };
+    std::uniform_int_distribution<std::size_t> length_dist { 1, 6 };
+
+    auto random_string = [&](std::size_t length) {
+        std::string out;
+        for (std::size_t i = 0; i < length; ++i)
+            out.push_back(static_cast<char>(c_dist(gen)));
+        return out;
+    };
+
+    std::vector<std::string> patterns;
+    for (std::size_t i = 0; i < 200; ++i)
+        patterns.push_back(random_string(length_dist(gen)));
+    dtree::aho_corasick automaton { patterns };
+
+    std::vector<std::uint32_t> visited(automaton.number_of_states(), 0u);
+    for (std::uint32_t stamp = 1; stamp <= 100; ++stamp) {
+        auto text = random_string(40);
+
+        std::vector<std::uint32_t> expected;
+        for (std::uint32_t id = 0; id < automaton.size(); ++id) {
+            if (text.find(automaton[id]) != std::string::npos)
+                expected.push_back(id);
+        }
+
+        // the visited states are shared between the texts
+        std::vector<std::uint32_t> seen;
+        automaton.for_each_pattern(
+            text, visited, stamp, [&seen](std::uint32_t id) { seen.push_back(id); });
+        std::sort(begin(seen), end(seen));
+
+        EXPECT_EQ(seen, expected) << text;
+    }
+}
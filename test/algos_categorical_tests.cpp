@@ -0,0 +1,111 @@
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/algos/categorical.h"
+#include "dtree/algos/cost_utils.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/labels.h"
+
+namespace {
+
+// the lowest cost of any subset of the categories 0, ..., n_categories - 1
+template <typename feature_t>
+double best_subset_cost(
+    const feature_t& feature, const dtree::labels& labels, std::uint32_t n_categories)
+{
+    double best_cost = dtree::gini_index(labels.get_label_counts());
+    for (std::uint64_t subset = 1; subset + 1 < (1u << n_categories); ++subset) {
+        best_cost = std::min(best_cost,
+            dtree::algos::calculate_cost(dtree::category_splitting { { subset } },
+                feature, labels, dtree::gini_index));
+    }
+    return best_cost;
+}
+
+} // namespace
+
+TEST(test_algos_categorical, test_category_split)
+{
+    std::vector<dtree::category> feature { { 0u }, { 1u }, { 2u }, { 0u }, { 3u },
+        { 1u }, { 2u }, { 3u } };
+    dtree::labels labels { 0u, 1u, 0u, 0u, 1u, 1u, 0u, 1u };
+
+    auto [cost, splitting]
+        = dtree::algos::category_split {}(feature, labels, dtree::gini_index);
+
+    EXPECT_DOUBLE_EQ(cost, 0.0);
+    EXPECT_TRUE(splitting(dtree::category { 0u }) == splitting(dtree::category { 2u }));
+    EXPECT_TRUE(splitting(dtree::category { 1u }) == splitting(dtree::category { 3u }));
+    EXPECT_TRUE(splitting(dtree::category { 0u }) != splitting(dtree::category { 1u }));
+}
+
+TEST(test_algos_categorical, test_binary_category_split_is_optimal)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<std::uint32_t> c_dist { 0, 9 };
+    std::uniform_real_distribution<double> u_dist;
+
+    for (std::size_t trial = 0; trial < 20; ++trial) {
+        std::vector<double> p(10);
+        for (auto& x : p)
+            x = u_dist(gen);
+
+        std::vector<dtree::category> feature;
+        dtree::labels labels;
+        for (std::size_t i = 0; i < 200; ++i) {
+            dtree::category sample { c_dist(gen) };
+            feature.push_back(sample);
+            labels.push_back(u_dist(gen) < p[sample.code] ? 1u : 0u);
+        }
+
+        auto [cost, splitting]
+            = dtree::algos::category_split {}(feature, labels, dtree::gini_index);
+
+        EXPECT_DOUBLE_EQ(cost, best_subset_cost(feature, labels, 10u));
+        EXPECT_DOUBLE_EQ(cost,
+            dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index));
+    }
+}
+
+TEST(test_algos_categorical, test_multi_class_category_split)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<std::uint32_t> c_dist { 0, 7 };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 3 };
+
+    std::vector<dtree::category> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 300; ++i) {
+        dtree::category sample { c_dist(gen) };
+        feature.push_back(sample);
+        // the label is mostly the category mod 4
+        labels.push_back(i % 3 == 0 ? l_dist(gen) : sample.code % 4);
+    }
+
+    auto [cost, splitting]
+        = dtree::algos::category_split {}(feature, labels, dtree::gini_index);
+
+    EXPECT_DOUBLE_EQ(cost,
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index));
+    EXPECT_LT(cost, dtree::gini_index(labels.get_label_counts()));
+    EXPECT_GE(cost, best_subset_cost(feature, labels, 8u));
+}
+
+TEST(test_algos_categorical, test_sparse_category_split)
+{
+    // codes far apart, as in a node of a feature with a large dictionary
+    std::vector<dtree::category> feature { { 70'000u }, { 5u }, { 1'000'000u },
+        { 5u }, { 70'000u }, { dtree::category_dictionary::unknown } };
+    dtree::labels labels { 1u, 0u, 1u, 0u, 1u, 0u };
+
+    auto [cost, splitting]
+        = dtree::algos::category_split {}(feature, labels, dtree::gini_index);
+
+    EXPECT_DOUBLE_EQ(cost, 0.0);
+    EXPECT_FALSE(splitting(dtree::category { dtree::category_dictionary::unknown }));
+    EXPECT_DOUBLE_EQ(cost,
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index));
+}
@@ -0,0 +1,88 @@
+#include <random>
+#include <valarray>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/algos/multi_numeric.h"
+#include "dtree/algos/single_numeric.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/labels.h"
+
+namespace {
+
+struct multi_numeric_data {
+    std::vector<std::valarray<double>> feature;
+    dtree::labels labels;
+};
+
+multi_numeric_data make_data(std::size_t n_samples, std::size_t n_features)
+{
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+
+    multi_numeric_data out;
+    for (std::size_t i = 0; i < n_samples; ++i) {
+        std::valarray<double> sample(n_features);
+        for (auto& x : sample)
+            x = f_dist(gen);
+        // an oblique boundary through the first two dimensions
+        out.labels.push_back(sample[0] + 0.5 * sample[1] > 0.2 ? 1u : 0u);
+        out.feature.push_back(std::move(sample));
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(test_algos_multi_numeric, test_random_hyperplane_split)
+{
+    auto [feature, labels] = make_data(1000, 64);
+
+    using algo_t = dtree::algos::random_hyperplane_split<dtree::algos::optimal_split>;
+    algo_t algo { dtree::algos::random_hyperplane_config { 17u, 8u } };
+
+    auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+    ASSERT_EQ(splitting.normal.size(), 64u);
+
+    // the cost is that of the normal and split returned
+    EXPECT_NEAR(
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index),
+        cost, 1e-12);
+
+    // the normals only depend on the seed and the node
+    auto [repeated_cost, repeated_splitting] = algo(feature, labels, dtree::gini_index);
+    EXPECT_EQ(repeated_splitting, splitting);
+
+    // the first normal drawn is the one a single projection would use
+    algo_t single_algo { dtree::algos::random_hyperplane_config { 17u, 1u } };
+    auto [single_cost, single_splitting]
+        = single_algo(feature, labels, dtree::gini_index);
+    EXPECT_LE(cost, single_cost);
+}
+
+TEST(test_algos_multi_numeric, test_projections)
+{
+    // sizes either side of a whole number of tiles
+    for (std::size_t n_samples : { 1u, 31u, 32u, 100u }) {
+        auto [feature, labels] = make_data(n_samples, 5);
+
+        dtree::algos::random_hyperplane_split<dtree::algos::median_split> algo {
+            dtree::algos::random_hyperplane_config { 3u, 4u }
+        };
+        auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+
+        std::vector<double> projections;
+        for (const auto& sample : feature) {
+            double projection = 0.0;
+            for (std::size_t d = 0; d < sample.size(); ++d)
+                projection += sample[d] * splitting.normal[d];
+            projections.push_back(projection);
+        }
+        auto [median_cost, median_splitting]
+            = dtree::algos::median_split {}(projections, labels, dtree::gini_index);
+
+        EXPECT_NEAR(splitting.split, median_splitting.split, 1e-12);
+        EXPECT_NEAR(cost, median_cost, 1e-12);
+    }
+}
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <random>
+#include <ranges>
 
 #include <gtest/gtest.h>
 
@@ -31,3 +34,211 @@ TEST(test_algos_single_numeric, test_median_split)
     EXPECT_EQ(splitting, dtree::single_numeric_splitting(0.75));
     EXPECT_DOUBLE_EQ(cost, 1.0 / 3.0);
 }
+
+TEST(test_algos_single_numeric, test_median_split_selection)
+{
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+
+    for (std::size_t n : { 1u, 2u, 999u, 1000u, 100'000u }) {
+        std::vector<double> feature;
+        dtree::labels labels;
+        for (std::size_t i = 0; i < n; ++i) {
+            feature.push_back(f_dist(gen));
+            labels.push_back(i % 2);
+        }
+
+        auto sorted = feature;
+        std::sort(begin(sorted), end(sorted));
+        double median = n % 2 == 1 ? sorted[n / 2]
+                                   : 0.5 * (sorted[n / 2] + sorted[n / 2 - 1]);
+
+        auto [cost, splitting]
+            = dtree::algos::median_split {}(feature, labels, dtree::gini_index);
+        EXPECT_EQ(splitting, dtree::single_numeric_splitting(median));
+
+        // exact up to the sample limit, above it within a few percent in rank
+        auto [sampled_cost, sampled_splitting]
+            = dtree::algos::median_split { 10'000u }(feature, labels, dtree::gini_index);
+        if (n <= 10'000u) {
+            EXPECT_EQ(sampled_splitting, splitting);
+        } else {
+            auto rank = std::upper_bound(
+                            begin(sorted), end(sorted), sampled_splitting.split)
+                - begin(sorted);
+            EXPECT_NEAR(rank / static_cast<double>(n), 0.5, 0.03);
+        }
+    }
+}
+
+TEST(test_algos_single_numeric, test_median_split_ordered_samples)
+{
+    // a period equal to the stride, which a sample taken at the start of every
+    // stride would see as the single value 0
+    std::vector<double> periodic;
+    std::vector<double> ordered;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 10'000u; ++i) {
+        periodic.push_back(i % 100);
+        ordered.push_back(i);
+        labels.push_back(i % 2);
+    }
+
+    dtree::algos::median_split split { 100u };
+    auto [periodic_cost, periodic_splitting]
+        = split(periodic, labels, dtree::gini_index);
+    EXPECT_NEAR(periodic_splitting.split, 49.5, 15.0);
+
+    auto [ordered_cost, ordered_splitting] = split(ordered, labels, dtree::gini_index);
+    EXPECT_NEAR(ordered_splitting.split, 4999.5, 1500.0);
+
+    // the same samples give the same split
+    EXPECT_EQ(split(periodic, labels, dtree::gini_index).second, periodic_splitting);
+}
+
+TEST(test_algos_single_numeric, test_split_sorted)
+{
+    std::vector<std::pair<double, dtree::labels::label_t>> data { { 0.2, 0u },
+        { 0.3, 0u }, { 0.6, 0u }, { 0.9, 0u }, { 4.5, 1u }, { 7.8, 1u } };
+    dtree::label_counts counts { 4u, 2u };
+
+    auto [optimal_cost, optimal_splitting]
+        = dtree::algos::optimal_split {}.split_sorted(data, counts, dtree::gini_index);
+
+    EXPECT_EQ(optimal_splitting, dtree::single_numeric_splitting(2.7));
+    EXPECT_DOUBLE_EQ(optimal_cost, 0.0);
+
+    auto [median_cost, median_splitting] = dtree::algos::median_split {}.split_sorted(
+        data, counts, [](auto&& labels) { return labels[0] / 6.0; });
+
+    EXPECT_EQ(median_splitting, dtree::single_numeric_splitting(0.75));
+    EXPECT_DOUBLE_EQ(median_cost, 1.0 / 3.0);
+}
+
+TEST(test_algos_single_numeric, test_histogram_split)
+{
+    std::vector<double> feature { 0.6, 4.5, 0.2, 0.3, 7.8, 0.9 };
+    dtree::labels labels { 0u, 1u, 0u, 0u, 1u, 0u };
+
+    dtree::algos::histogram_split algo;
+
+    auto [cost, splitting]
+        = algo(dtree::make_binned_feature(feature), labels, dtree::gini_index);
+
+    EXPECT_EQ(splitting, dtree::single_numeric_splitting(2.7));
+    EXPECT_DOUBLE_EQ(cost, 0.0);
+}
+
+TEST(test_algos_single_numeric, test_incremental_cost_fns)
+{
+    // a long scan over skewed labels, where the costs are small and an accumulator's
+    // running sums have many steps to drift over
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+    std::discrete_distribution<std::size_t> l_dist { 1000.0, 30.0, 3.0, 1.0 };
+
+    std::vector<double> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 20'000; ++i) {
+        feature.push_back(f_dist(gen));
+        labels.push_back(l_dist(gen));
+    }
+    auto binned = dtree::make_binned_feature(feature, 64);
+
+    auto check = [&](auto cost_fn, auto incremental_cost_fn) {
+        auto [cost, splitting]
+            = dtree::algos::optimal_split {}(feature, labels, cost_fn);
+        auto [incremental_cost, incremental_splitting]
+            = dtree::algos::optimal_split {}(feature, labels, incremental_cost_fn);
+        EXPECT_DOUBLE_EQ(incremental_cost, cost);
+        EXPECT_EQ(incremental_splitting, splitting);
+
+        auto [histogram_cost, histogram_splitting]
+            = dtree::algos::histogram_split {}(binned, labels, cost_fn);
+        auto [incremental_histogram_cost, incremental_histogram_splitting]
+            = dtree::algos::histogram_split {}(binned, labels, incremental_cost_fn);
+        EXPECT_DOUBLE_EQ(incremental_histogram_cost, histogram_cost);
+        EXPECT_EQ(incremental_histogram_splitting, histogram_splitting);
+    };
+
+    check(dtree::gini_index, dtree::gini_impurity {});
+    check(dtree::entropy, dtree::entropy_impurity {});
+}
+
+TEST(test_algos_single_numeric, test_binary_optimal_split)
+{
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    std::vector<double> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        feature.push_back(f_dist(gen));
+        labels.push_back(l_dist(gen) + (feature.back() > 0.3 ? 1u : 0u) > 0);
+    }
+
+    auto check = [&](auto cost_fn, auto binary_cost_fn) {
+        auto [cost, splitting]
+            = dtree::algos::optimal_split {}(feature, labels, cost_fn);
+        auto [binary_cost, binary_splitting]
+            = dtree::algos::basic_optimal_split<2> {}(feature, labels, binary_cost_fn);
+        EXPECT_NEAR(binary_cost, cost, 1e-12);
+        EXPECT_EQ(binary_splitting, splitting);
+    };
+
+    check(dtree::gini_index, dtree::gini_impurity {});
+    check(dtree::entropy, dtree::entropy_impurity {});
+    // a cost function without a closed form is given the counts as label_counts
+    check(dtree::gini_index, dtree::gini_index);
+
+    dtree::labels three_labels { 0u, 1u, 2u, 0u, 1u, 2u };
+    EXPECT_THROW(dtree::algos::basic_optimal_split<2> {}(
+                     std::vector<double>(6, 1.0), three_labels, dtree::gini_index),
+        std::runtime_error);
+}
+
+TEST(test_algos_single_numeric, test_calculate_cost)
+{
+    std::mt19937 gen {};
+    std::normal_distribution<double> f_dist;
+
+    std::vector<double> feature;
+    std::vector<float> float_feature;
+    for (std::size_t i = 0; i < 1000; ++i) {
+        feature.push_back(f_dist(gen));
+        float_feature.push_back(static_cast<float>(feature.back()));
+    }
+    // not contiguous, so costed a sample at a time
+    auto feature_view = feature | std::views::transform([](double x) { return x; });
+    auto float_view = float_feature | std::views::transform([](float x) { return x; });
+
+    // both sides of the number of labels counted by compare and add
+    for (std::size_t n_labels : { 2u, 3u, 20u }) {
+        std::uniform_int_distribution<std::size_t> l_dist { 0, n_labels - 1 };
+        dtree::labels labels;
+        std::vector<std::size_t> index;
+        for (std::size_t i = 0; i < feature.size(); ++i) {
+            labels.push_back(l_dist(gen));
+            index.push_back(i);
+        }
+        dtree::labels_view<dtree::labels> view { labels, index };
+
+        for (double split : { -3.0, -0.2, 0.0, 0.7, 3.0 }) {
+            dtree::single_numeric_splitting splitting { split };
+            double cost = dtree::algos::calculate_cost(
+                splitting, feature_view, labels, dtree::gini_index);
+
+            EXPECT_DOUBLE_EQ(dtree::algos::calculate_cost(
+                                 splitting, feature, labels, dtree::gini_index),
+                cost);
+            EXPECT_DOUBLE_EQ(dtree::algos::calculate_cost(
+                                 splitting, feature, view, dtree::gini_index),
+                cost);
+            EXPECT_DOUBLE_EQ(dtree::algos::calculate_cost(
+                                 splitting, float_feature, labels, dtree::gini_index),
+                dtree::algos::calculate_cost(
+                    splitting, float_view, labels, dtree::gini_index));
+        }
+    }
+}
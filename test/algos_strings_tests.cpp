@@ -0,0 +1,202 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/algos/cost_utils.h"
+#include "dtree/algos/strings.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/labels.h"
+
+TEST(test_algos_strings, test_substring_split)
+{
+    std::vector<std::string> feature { "GET /index.html 200", "GET /admin 403",
+        "POST /login 200", "POST /admin 403", "GET /login 500", "GET /admin 401" };
+    dtree::labels labels { 0u, 1u, 0u, 1u, 2u, 1u };
+
+    dtree::algos::substring_split algo { std::vector<std::string> {
+        "GET", "admin", "login", "200", "4" } };
+
+    auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+
+    EXPECT_EQ(splitting, dtree::has_substring_splitting { "admin" });
+    EXPECT_DOUBLE_EQ(cost,
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index));
+}
+
+TEST(test_algos_strings, test_substring_split_against_find)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<int> c_dist { 'a', 'e' };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 2 };
+
+    auto random_string = [&](std::size_t length) {
+        std::string out;
+        for (std::size_t i = 0; i < length; ++i)
+            out.push_back(static_cast<char>(c_dist(gen)));
+        return out;
+    };
+
+    std::vector<std::string> corpus;
+    for (std::size_t i = 0; i < 100; ++i)
+        corpus.push_back(random_string(1 + i % 4));
+
+    std::vector<std::string> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 300; ++i) {
+        feature.push_back(random_string(20));
+        labels.push_back(l_dist(gen));
+    }
+
+    auto [cost, splitting]
+        = dtree::algos::substring_split { corpus }(feature, labels, dtree::gini_index);
+
+    double best_cost = std::numeric_limits<double>::max();
+    for (const auto& substring : corpus) {
+        best_cost = std::min(best_cost,
+            dtree::algos::calculate_cost(dtree::has_substring_splitting { substring },
+                feature, labels, dtree::gini_index));
+    }
+
+    EXPECT_DOUBLE_EQ(cost, best_cost);
+    EXPECT_DOUBLE_EQ(
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index),
+        best_cost);
+}
+
+TEST(test_algos_strings, test_substring_split_empty_corpus)
+{
+    std::vector<std::string> feature { "abc", "abd", "bcd", "cde" };
+    dtree::labels labels { 0u, 1u, 0u, 1u };
+    double no_split_cost = dtree::gini_index(labels.get_label_counts());
+
+    dtree::algos::substring_split algo { std::vector<std::string> {} };
+    auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+    EXPECT_DOUBLE_EQ(cost, no_split_cost);
+    EXPECT_DOUBLE_EQ(
+        dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index),
+        no_split_cost);
+}
+
+TEST(test_algos_strings, test_mined_substring_split)
+{
+    std::vector<std::string> feature { "GET /index.html 200", "GET /admin 403",
+        "POST /login 200", "POST /admin 403", "GET /login 500", "GET /admin 401" };
+    dtree::labels labels { 0u, 1u, 0u, 1u, 0u, 1u };
+
+    auto [cost, splitting]
+        = dtree::algos::mined_substring_split {}(feature, labels, dtree::gini_index);
+
+    // a single character separates the admin requests from the rest
+    EXPECT_DOUBLE_EQ(cost, 0.0);
+    EXPECT_EQ(splitting.substring.size(), 1u);
+    for (std::size_t i = 0; i < feature.size(); ++i)
+        EXPECT_EQ(splitting(feature[i]), splitting(feature[1]) == (labels[i] == 1u));
+}
+
+TEST(test_algos_strings, test_mined_substring_split_against_find)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<int> c_dist { 'a', 'd' };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 2 };
+
+    std::vector<std::string> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 60; ++i) {
+        std::string sample;
+        for (std::size_t j = 0; j < 1 + i % 10; ++j)
+            sample.push_back(static_cast<char>(c_dist(gen)));
+        feature.push_back(sample);
+        labels.push_back(l_dist(gen));
+    }
+
+    for (std::size_t min_support : { 1u, 5u, 20u }) {
+        for (std::size_t max_length : { 2u, 64u }) {
+            dtree::algos::mined_substring_split algo { { min_support, max_length } };
+            auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+
+            double best_cost = std::numeric_limits<double>::max();
+            for (const auto& sample : feature) {
+                for (std::size_t first = 0; first < sample.size(); ++first) {
+                    for (std::size_t length = 1;
+                         length <= std::min(max_length, sample.size() - first);
+                         ++length) {
+                        dtree::has_substring_splitting candidate { sample.substr(
+                            first, length) };
+                        auto below = std::ranges::count_if(feature, candidate);
+                        if (static_cast<std::size_t>(below) < min_support
+                            || feature.size() - below < min_support)
+                            continue;
+
+                        best_cost = std::min(best_cost,
+                            dtree::algos::calculate_cost(
+                                candidate, feature, labels, dtree::gini_index));
+                    }
+                }
+            }
+
+            EXPECT_DOUBLE_EQ(cost, best_cost);
+            EXPECT_LE(splitting.substring.size(), max_length);
+            EXPECT_DOUBLE_EQ(dtree::algos::calculate_cost(
+                                 splitting, feature, labels, dtree::gini_index),
+                best_cost);
+        }
+    }
+}
+
+TEST(test_algos_strings, test_no_substring_qualifies)
+{
+    std::vector<std::string> feature { "abc", "abd", "bcd", "cde" };
+    dtree::labels labels { 0u, 1u, 0u, 1u };
+    double no_split_cost = dtree::gini_index(labels.get_label_counts());
+
+    // neither side of any split can hold 3 of the 4 samples
+    auto [mined_cost, mined_splitting]
+        = dtree::algos::mined_substring_split { { 3u, 64u } }(
+            feature, labels, dtree::gini_index);
+    EXPECT_DOUBLE_EQ(mined_cost, no_split_cost);
+    EXPECT_EQ(mined_splitting, dtree::has_substring_splitting {});
+}
+
+TEST(test_algos_strings, test_mined_substring_split_sample_limit)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<int> c_dist { 'a', 'd' };
+    std::uniform_int_distribution<std::size_t> l_dist { 0, 1 };
+
+    // the label 1 samples, and only those, contain an 'x'
+    std::vector<std::string> feature;
+    dtree::labels labels;
+    for (std::size_t i = 0; i < 2000; ++i) {
+        std::size_t label = l_dist(gen);
+        std::string sample;
+        for (std::size_t j = 0; j < 8; ++j)
+            sample.push_back(static_cast<char>(c_dist(gen)));
+        if (label == 1u)
+            sample[i % 8] = 'x';
+        feature.push_back(sample);
+        labels.push_back(label);
+    }
+
+    for (std::size_t sample_limit : { 50u, 500u }) {
+        dtree::algos::mined_substring_split algo { { 10u, 64u, sample_limit } };
+        auto [cost, splitting] = algo(feature, labels, dtree::gini_index);
+
+        EXPECT_DOUBLE_EQ(cost, 0.0);
+        EXPECT_EQ(splitting.substring, "x");
+        EXPECT_DOUBLE_EQ(
+            dtree::algos::calculate_cost(splitting, feature, labels, dtree::gini_index),
+            cost);
+    }
+
+    // a limit above the number of samples mines all of them
+    auto [cost, splitting]
+        = dtree::algos::mined_substring_split { { 10u, 64u, 2000u } }(
+            feature, labels, dtree::gini_index);
+    auto [all_cost, all_splitting]
+        = dtree::algos::mined_substring_split { { 10u, 64u } }(
+            feature, labels, dtree::gini_index);
+    EXPECT_EQ(cost, all_cost);
+    EXPECT_EQ(splitting, all_splitting);
+}
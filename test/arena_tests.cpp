@@ -0,0 +1,70 @@
+#include <cstdint>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/arena.h"
+
+TEST(test_arena_resource, test_allocations_are_aligned)
+{
+    dtree::arena_resource arena { 256 };
+
+    for (std::size_t alignment : { 1u, 8u, 16u, 64u }) {
+        void* p = arena.allocate(3, alignment);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignment, 0u);
+    }
+
+    // larger than a block
+    void* p = arena.allocate(1000, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0u);
+    EXPECT_GE(arena.capacity(), 1000u);
+}
+
+TEST(test_arena_resource, test_rewind_reuses_memory)
+{
+    dtree::arena_resource arena { 1024 };
+
+    auto mark = arena.mark();
+    void* first = arena.allocate(100, 8);
+    for (std::size_t i = 0; i < 20; ++i)
+        EXPECT_NE(arena.allocate(100, 8), first);
+    std::size_t capacity = arena.capacity();
+
+    arena.rewind(mark);
+    EXPECT_EQ(arena.allocate(100, 8), first);
+    for (std::size_t i = 0; i < 20; ++i)
+        EXPECT_NE(arena.allocate(100, 8), first);
+    EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(test_arena_resource, test_scratch_scopes_nest)
+{
+    void* outer_data = nullptr;
+    {
+        dtree::scratch_scope outer;
+        std::pmr::vector<int> outer_values(10, 1, outer.resource());
+        outer_data = outer_values.data();
+
+        {
+            dtree::scratch_scope inner;
+            std::pmr::vector<int> inner_values(10, 2, inner.resource());
+            EXPECT_NE(static_cast<void*>(inner_values.data()), outer_data);
+        }
+
+        // the inner scope's memory is reused, the outer values are untouched
+        std::pmr::vector<int> more_values(10, 3, outer.resource());
+        for (int x : outer_values)
+            EXPECT_EQ(x, 1);
+    }
+
+    dtree::scratch_scope scope;
+    std::pmr::vector<int> values(10, 4, scope.resource());
+    EXPECT_EQ(static_cast<void*>(values.data()), outer_data);
+
+    // every thread has its own arena
+    std::thread { [&scope]() {
+        EXPECT_NE(&dtree::scratch_arena(), scope.resource());
+    } }.join();
+}
@@ -0,0 +1,95 @@
+
+#include <random>
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include "dtree/binning.h"
+
+TEST(test_binning, test_quantile_edges_few_distinct_values)
+{
+    std::vector<double> values { 0.2, 0.3, 0.3, 0.6, 0.9, 4.5, 7.8 };
+
+    EXPECT_THAT(dtree::quantile_edges(values, 255),
+        ::testing::Pointwise(
+            ::testing::DoubleEq(), { 0.25, 0.45, 0.75, 2.7, 6.15, 7.8 }));
+}
+
+TEST(test_binning, test_quantile_edges_many_values)
+{
+    std::vector<double> values(1000);
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<double>(i / 2);
+
+    auto edges = dtree::quantile_edges(values, 10);
+
+    ASSERT_EQ(edges.size(), 10u);
+    EXPECT_DOUBLE_EQ(edges.front(), 49.5);
+    EXPECT_DOUBLE_EQ(edges.back(), 499.0);
+}
+
+TEST(test_binning, test_make_binned_feature)
+{
+    std::vector<double> feature { 0.6, 4.5, 0.2, 0.3, 7.8, 0.9 };
+
+    auto binned = dtree::make_binned_feature(feature);
+
+    EXPECT_THAT(binned.codes(), ::testing::ElementsAre(2, 4, 0, 1, 5, 3));
+    EXPECT_THAT(binned,
+        ::testing::Pointwise(
+            ::testing::DoubleEq(), { 0.75, 6.15, 0.25, 0.45, 7.8, 2.7 }));
+
+    auto selected = binned.select(std::vector<std::size_t> { 1, 3 });
+    EXPECT_THAT(selected, ::testing::Pointwise(::testing::DoubleEq(), { 6.15, 0.45 }));
+    EXPECT_EQ(selected.number_of_bins(), 6u);
+}
+
+TEST(test_binning, test_binned_splits_match_raw_splits)
+{
+    std::mt19937 gen {};
+    std::normal_distribution<double> dist;
+
+    std::vector<double> feature(5000);
+    for (auto& x : feature)
+        x = dist(gen);
+
+    auto binned = dtree::make_binned_feature(feature);
+    ASSERT_LE(binned.number_of_bins(), dtree::binned_feature::max_bins);
+
+    for (double edge : binned.edges()) {
+        for (std::size_t i = 0; i < feature.size(); ++i)
+            ASSERT_EQ(feature[i] <= edge, binned[i] <= edge);
+    }
+}
+
+TEST(test_binning, test_label_histogram)
+{
+    std::vector<double> feature { 0.6, 4.5, 0.2, 0.3, 7.8, 0.9, 0.3 };
+    dtree::labels labels { 0u, 1u, 0u, 2u, 1u, 0u, 0u };
+
+    dtree::label_histogram histogram { dtree::make_binned_feature(feature), labels };
+
+    ASSERT_EQ(histogram.number_of_bins(), 6u);
+    ASSERT_EQ(histogram.number_of_labels(), 3u);
+    EXPECT_EQ(histogram(1, 0), 1u);
+    EXPECT_EQ(histogram(1, 2), 1u);
+    EXPECT_EQ(histogram(5, 1), 1u);
+    EXPECT_EQ(histogram(5, 0), 0u);
+}
+
+TEST(test_binning, test_label_histogram_subtraction)
+{
+    std::vector<double> feature { 0.6, 4.5, 0.2, 0.3, 7.8, 0.9, 0.3 };
+    dtree::labels labels { 0u, 1u, 0u, 2u, 1u, 0u, 0u };
+
+    auto binned = dtree::make_binned_feature(feature);
+    dtree::label_histogram histogram { binned, labels };
+
+    dtree::label_histogram lower { binned.number_of_bins(), labels.number_of_labels() };
+    lower.add(binned, labels, std::vector<std::size_t> { 0, 2, 3, 5, 6 });
+    dtree::label_histogram upper { binned.number_of_bins(), labels.number_of_labels() };
+    upper.add(binned, labels, std::vector<std::size_t> { 1, 4 });
+
+    histogram -= lower;
+    EXPECT_EQ(histogram, upper);
+}
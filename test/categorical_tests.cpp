@@ -0,0 +1,49 @@
+#include <string>
+#include <vector>
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include "dtree/categorical.h"
+
+TEST(test_categorical, test_category_dictionary)
+{
+    dtree::category_dictionary dictionary;
+
+    EXPECT_EQ(dictionary.intern("red"), 0u);
+    EXPECT_EQ(dictionary.intern("green"), 1u);
+    EXPECT_EQ(dictionary.intern("red"), 0u);
+    EXPECT_EQ(dictionary.intern("blue"), 2u);
+
+    ASSERT_EQ(dictionary.size(), 3u);
+    EXPECT_EQ(dictionary[1], "green");
+    EXPECT_EQ(dictionary.find("blue"), 2u);
+    EXPECT_EQ(dictionary.find("yellow"), dtree::category_dictionary::unknown);
+}
+
+TEST(test_categorical, test_make_categorical_feature)
+{
+    std::vector<std::string> feature { "GET", "POST", "GET", "PUT", "POST" };
+
+    auto categorical = dtree::make_categorical_feature(feature);
+
+    std::vector<dtree::category> categories(begin(categorical), end(categorical));
+    EXPECT_THAT(categories,
+        ::testing::ElementsAre(dtree::category { 0u }, dtree::category { 1u },
+            dtree::category { 0u }, dtree::category { 2u }, dtree::category { 1u }));
+    EXPECT_EQ(categorical.number_of_categories(), 3u);
+    EXPECT_EQ(categorical.dictionary()[categorical[3].code], "PUT");
+
+    auto selected = categorical.select(std::vector<std::size_t> { 1, 3 });
+    ASSERT_EQ(selected.size(), 2u);
+    EXPECT_EQ(selected[0], dtree::category { 1u });
+    EXPECT_EQ(selected[1], dtree::category { 2u });
+    EXPECT_EQ(selected.shared_dictionary(), categorical.shared_dictionary());
+
+    // new samples are encoded with the dictionary trained on
+    auto encoded = dtree::make_categorical_feature(
+        std::vector<std::string> { "PUT", "DELETE" }, categorical.shared_dictionary());
+    ASSERT_EQ(encoded.size(), 2u);
+    EXPECT_EQ(encoded[0], dtree::category { 2u });
+    EXPECT_EQ(encoded[1], dtree::category { dtree::category_dictionary::unknown });
+}
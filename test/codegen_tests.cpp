@@ -0,0 +1,103 @@
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include <boost/archive/text_iarchive.hpp>
+#include <gtest/gtest.h>
+
+#include "dtree/codegen.h"
+#include "dtree/serialization.h"
+#include "small_model_scoring/score.h"
+
+namespace {
+
+std::string literal(double value)
+{
+    std::stringstream out;
+    dtree::write_literal(out, value);
+    return out.str();
+}
+
+} // namespace
+
+TEST(test_codegen, test_write_literal)
+{
+    EXPECT_EQ(literal(0.5), "0.5");
+    EXPECT_EQ(literal(-2.0), "-2.0");
+    EXPECT_EQ(literal(1e300), "1e+300");
+    EXPECT_EQ(literal(-std::numeric_limits<double>::infinity()),
+        "-std::numeric_limits<double>::infinity()");
+
+    std::mt19937 gen {};
+    std::normal_distribution<double> dist;
+    for (int i = 0; i < 1000; ++i) {
+        double x = dist(gen);
+        EXPECT_EQ(std::strtod(literal(x).c_str(), nullptr), x);
+    }
+}
+
+TEST(test_codegen, test_write_cpp)
+{
+    using namespace dtree;
+    using node_type = node<single_numeric_splitting>;
+    flat_tree<node_type, binary_leaf> tree { 2 };
+    tree[0] = node_type { 3u, { 0.5 } };
+    tree[1] = binary_leaf { 0.25 };
+    tree[2] = node_type { 0u, { -1.0 } };
+    tree[5] = binary_leaf { 1.0 };
+    tree[6] = binary_leaf { 0.125 };
+
+    std::stringstream out;
+    write_cpp(out, tree, codegen_config { "model", "probability" });
+    EXPECT_EQ(out.str(),
+        "// Generated by dtree::write_cpp, do not edit.\n"
+        "#pragma once\n"
+        "\n"
+        "#include <array>\n"
+        "#include <limits>\n"
+        "\n"
+        "namespace model {\n"
+        "\n"
+        "template <typename sample_t>\n"
+        "constexpr double probability([[maybe_unused]] const sample_t& sample)\n"
+        "{\n"
+        "    if (sample[3] <= 0.5) {\n"
+        "        return 0.25;\n"
+        "    } else {\n"
+        "        if (sample[0] <= -1.0) {\n"
+        "            return 1.0;\n"
+        "        } else {\n"
+        "            return 0.125;\n"
+        "        }\n"
+        "    }\n"
+        "}\n"
+        "\n"
+        "} // namespace model\n");
+}
+
+// small_model_scoring is compiled from data/small_model.txt by
+// dtree_add_scoring_library
+TEST(test_codegen, test_generated_function_matches_tree)
+{
+    dtree::flat_tree<dtree::node<dtree::single_numeric_splitting>> tree;
+    std::ifstream model { DTREE_TEST_DATA_DIR "/small_model.txt" };
+    boost::archive::text_iarchive archive { model };
+    archive >> tree;
+
+    static_assert(small_model::score(std::array { 0.0, 0.0, 0.0 }).size() == 3);
+
+    std::mt19937 gen {};
+    std::normal_distribution<double> dist;
+    for (int i = 0; i < 1000; ++i) {
+        std::array sample { dist(gen), dist(gen), dist(gen) };
+        const auto& expected = tree.apply(sample);
+        auto value = small_model::score(sample);
+        for (std::size_t label = 0; label < value.size(); ++label) {
+            EXPECT_EQ(value[label], label < expected.size() ? expected[label] : 0.0);
+        }
+    }
+}
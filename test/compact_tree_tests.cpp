@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include "dtree/algos/single_numeric.h"
+#include "dtree/compact_tree.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/splittings.h"
+#include "dtree/tree_builder.h"
+#include "dtree/types.h"
+
+#include "test_utils.h"
+
+namespace {
+
+struct test_splitting {
+    template <typename T> bool operator()(const T& t) const { return t <= 0; }
+};
+
+using test_node = dtree::node<test_splitting>;
+
+using dtree::tests::make_labels;
+using dtree::tests::make_random_features;
+using dtree::tests::sample_of;
+
+std::vector<double> to_vector(std::span<const double> value)
+{
+    return { value.begin(), value.end() };
+}
+
+} // namespace
+
+TEST(test_compact_tree, test_from_flat_tree)
+{
+    dtree::flat_tree<test_node> flat { 3 };
+    flat[0] = test_node { 0u, test_splitting {} };
+    flat[1] = test_node { 0u, test_splitting {} };
+    flat[2] = dtree::leaf { { 0.25, 0.25, 0.5 } };
+    flat[3] = test_node { 1u, test_splitting {} };
+    flat[4] = dtree::leaf { { 0.2, 0.8 } };
+    flat[7] = dtree::leaf { { 0.66, 0.12, 0.22 } };
+    flat[8] = dtree::leaf { { 0.1, 0.2, 0.7 } };
+
+    dtree::compact_tree<test_node> tree { flat };
+
+    // only the reachable nodes, with the siblings next to each other
+    EXPECT_EQ(tree.size(), 7u);
+    EXPECT_EQ(tree[0].child, 1u);
+    EXPECT_EQ(tree[1].child, 3u);
+    EXPECT_TRUE(tree[2].is_leaf());
+    EXPECT_EQ(tree[3].child, 5u);
+    EXPECT_EQ(tree.width(), 3u);
+    EXPECT_EQ(tree.values().size(), 4u * 3u);
+
+    EXPECT_THAT(to_vector(tree.apply(std::array { 1.0, 0.5 })),
+        ::testing::ElementsAreArray({ 0.25, 0.25, 0.5 }));
+    EXPECT_THAT(to_vector(tree.apply(std::array { -0.1, 0.9 })),
+        ::testing::ElementsAreArray({ 0.1, 0.2, 0.7 }));
+    EXPECT_THAT(to_vector(tree.apply(std::array { -0.1, -0.9 })),
+        ::testing::ElementsAreArray({ 0.66, 0.12, 0.22 }));
+
+    // a shorter distribution is padded with zeros
+    dtree::flat_tree<test_node> shallow { 1 };
+    shallow[0] = test_node { 0u, test_splitting {} };
+    shallow[1] = dtree::leaf { { 0.2, 0.8 } };
+    shallow[2] = dtree::leaf { { 0.1, 0.2, 0.7 } };
+    dtree::compact_tree<test_node> padded { shallow };
+    EXPECT_THAT(to_vector(padded.apply(std::array { -1.0 })),
+        ::testing::ElementsAreArray({ 0.2, 0.8, 0.0 }));
+}
+
+TEST(test_compact_tree, test_matches_flat_tree)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 12u, 1u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 3));
+
+    dtree::compact_tree tree { flat };
+    EXPECT_EQ(sizeof(tree[0]), 16u);
+    EXPECT_LT(tree.size(), flat.data().size() / 4);
+
+    auto test = make_random_features(3, 1000, 2u);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        const auto& expected = flat.apply(sample);
+        auto value = tree.apply(sample);
+        EXPECT_EQ(std::vector(value.begin(), value.begin() + expected.size()), expected);
+    }
+}
+
+TEST(test_compact_tree, test_binary_matches_flat_tree)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 7u, 1u, 1.0 },
+        dtree::algos::basic_optimal_split<2> {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 2));
+
+    dtree::compact_tree tree { flat };
+    EXPECT_TRUE(tree.splittings().empty());
+    EXPECT_EQ(tree.width(), 1u);
+
+    auto test = make_random_features(3, 1000, 2u);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        EXPECT_EQ(tree.apply(sample), flat.apply(sample));
+    }
+}
+
+TEST(test_compact_tree, test_pooled_splittings)
+{
+    using node_type = dtree::node<dtree::multi_numeric_splitting>;
+    dtree::flat_tree<node_type> flat { 1 };
+    flat[0] = node_type { 0u, { { 1.0, -1.0 }, 0.0 } };
+    flat[1] = dtree::leaf { { 1.0, 0.0 } };
+    flat[2] = dtree::leaf { { 0.0, 1.0 } };
+
+    dtree::compact_tree tree { flat };
+    EXPECT_EQ(tree.splittings().size(), 1u);
+    EXPECT_EQ(tree.splitting(tree[0]), std::get<node_type>(flat[0]).splitting);
+
+    std::vector<std::vector<double>> below { { 1.0, 2.0 } };
+    std::vector<std::vector<double>> above { { 2.0, 1.0 } };
+    EXPECT_THAT(to_vector(tree.apply(below)), ::testing::ElementsAreArray({ 1.0, 0.0 }));
+    EXPECT_THAT(to_vector(tree.apply(above)), ::testing::ElementsAreArray({ 0.0, 1.0 }));
+}
+
+TEST(test_compact_tree, test_feature_id_out_of_range)
+{
+    // UINT32_MAX would be read as the no_feature of a leaf
+    dtree::flat_tree<test_node> flat { 1 };
+    flat[0] = test_node { UINT32_MAX, test_splitting {} };
+    flat[1] = dtree::leaf { { 1.0 } };
+    flat[2] = dtree::leaf { { 1.0 } };
+
+    EXPECT_THROW(dtree::compact_tree<test_node> { flat }, std::runtime_error);
+}
+
+TEST(test_compact_tree, test_van_emde_boas_layout)
+{
+    // a complete tree of depth 3, the splits having their breadth first location as
+    // feature so the order of the nodes can be read back
+    dtree::flat_tree<test_node> flat { 3 };
+    for (std::size_t loc = 0; loc < 7; ++loc)
+        flat[loc] = test_node { loc, test_splitting {} };
+    for (std::size_t loc = 7; loc < 15; ++loc)
+        flat[loc] = dtree::leaf { { static_cast<double>(loc) } };
+
+    auto tree = dtree::van_emde_boas_layout(dtree::compact_tree<test_node> { flat });
+
+    // the top two levels, then each subtree below them
+    std::vector<std::size_t> order;
+    for (const auto& node : tree.nodes())
+        order.push_back(node.is_leaf() ? 7 + node.child : node.feature_id);
+    EXPECT_THAT(order,
+        ::testing::ElementsAreArray(
+            { 0, 1, 2, 3, 4, 7, 8, 9, 10, 5, 6, 11, 12, 13, 14 }));
+
+    EXPECT_EQ(tree.nodes()[1].child, 3u);
+    EXPECT_EQ(tree.nodes()[2].child, 9u);
+    EXPECT_EQ(tree.nodes()[3].child, 5u);
+}
+
+TEST(test_compact_tree, test_van_emde_boas_layout_matches)
+{
+    auto train = make_random_features(3, 2000, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 16u, 1u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    dtree::compact_tree tree { builder.build(train, make_labels(train, 3)) };
+    auto reordered = dtree::van_emde_boas_layout(tree);
+
+    EXPECT_EQ(reordered.size(), tree.size());
+    EXPECT_EQ(reordered.values(), tree.values());
+
+    auto test = make_random_features(3, 1000, 2u);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        EXPECT_EQ(to_vector(reordered.apply(sample)), to_vector(tree.apply(sample)));
+    }
+}
@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include <gmock/gmock-matchers.h>
+#include <gtest/gtest.h>
+
+#include "dtree/algos/single_numeric.h"
+#include "dtree/complete_tree.h"
+#include "dtree/dataset.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/tree_builder.h"
+#include "dtree/types.h"
+
+#include "test_utils.h"
+
+namespace {
+
+using node_type = dtree::node<dtree::single_numeric_splitting>;
+
+using dtree::tests::make_labels;
+using dtree::tests::make_random_dataset;
+using dtree::tests::sample_of;
+
+std::vector<double> to_vector(std::span<const double> value)
+{
+    return { value.begin(), value.end() };
+}
+
+} // namespace
+
+TEST(test_complete_tree, test_pads_early_leaves)
+{
+    dtree::flat_tree<node_type> flat { 2 };
+    flat[0] = node_type { 1u, { 0.5 } };
+    flat[1] = dtree::leaf { { 0.25, 0.75 } };
+    flat[2] = node_type { 0u, { -1.0 } };
+    flat[5] = dtree::leaf { { 1.0, 0.0 } };
+    flat[6] = dtree::leaf { { 0.5, 0.5, 0.0 } };
+
+    dtree::complete_tree tree { flat };
+    EXPECT_EQ(tree.depth(), 2u);
+    EXPECT_EQ(tree.width(), 3u);
+    // the leaf at depth 1 is pushed down by a split that sends everything lower
+    EXPECT_EQ(tree.thresholds()[1], std::numeric_limits<double>::infinity());
+
+    EXPECT_EQ(tree.find_leaf(std::vector { 0.0, 0.0 }), 0u);
+    EXPECT_EQ(tree.find_leaf(std::vector { -2.0, 1.0 }), 2u);
+    EXPECT_EQ(tree.find_leaf(std::vector { 0.0, 1.0 }), 3u);
+    EXPECT_THAT(to_vector(tree.apply(std::vector { 0.0, 0.0 })),
+        ::testing::ElementsAreArray({ 0.25, 0.75, 0.0 }));
+    EXPECT_THAT(to_vector(tree.apply(std::vector { -2.0, 1.0 })),
+        ::testing::ElementsAreArray({ 1.0, 0.0, 0.0 }));
+
+    // NaN fails x <= t, including that of the padding
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(tree.find_leaf(std::vector { nan, nan }), 3u);
+}
+
+TEST(test_complete_tree, test_single_leaf)
+{
+    dtree::flat_tree<node_type, dtree::binary_leaf> flat { 0 };
+    flat[0] = dtree::binary_leaf { 0.25 };
+
+    dtree::complete_tree tree { flat };
+    EXPECT_EQ(tree.depth(), 0u);
+    EXPECT_EQ(tree.apply(std::vector<double> {}), 0.25);
+
+    auto batch = make_random_dataset(1, 20, 1u);
+    std::vector<double> out(20);
+    tree.apply_batch(batch, std::span { out });
+    EXPECT_THAT(out, ::testing::Each(0.25));
+
+    // a batch without features is enough for a tree that reads none
+    dtree::dataset no_features { 0u, 20u };
+    std::vector<double> no_features_out(20);
+    tree.apply_batch(no_features, std::span { no_features_out });
+    EXPECT_THAT(no_features_out, ::testing::Each(0.25));
+}
+
+TEST(test_complete_tree, test_feature_id_out_of_range)
+{
+    // UINT32_MAX would wrap the number of features the tree reads to 0
+    dtree::flat_tree<node_type> flat { 1 };
+    flat[0] = node_type { UINT32_MAX, { 0.5 } };
+    flat[1] = dtree::leaf { { 1.0 } };
+    flat[2] = dtree::leaf { { 1.0 } };
+    EXPECT_THROW(dtree::complete_tree { flat }, std::runtime_error);
+}
+
+TEST(test_complete_tree, test_matches_flat_tree)
+{
+    auto train = make_random_dataset(4, 2000, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 8u, 20u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 3));
+
+    dtree::complete_tree tree { flat };
+    EXPECT_EQ(tree.depth(), 8u);
+
+    // not a whole number of vectors, so the scalar tail runs too
+    std::size_t n = 1013;
+    auto batch = make_random_dataset(4, n, 2u);
+    std::vector<std::uint32_t> slots(n);
+    tree.apply_batch(batch, std::span { slots });
+    std::vector<double> out(n * tree.width());
+    tree.apply_batch(batch, std::span { out });
+
+    for (std::size_t i = 0; i < n; ++i) {
+        auto sample = sample_of(batch, i);
+        EXPECT_EQ(slots[i], tree.find_leaf(sample));
+
+        const auto& expected = flat.apply(sample);
+        auto row = std::span { out }.subspan(i * tree.width(), expected.size());
+        EXPECT_EQ(to_vector(row), expected);
+    }
+
+    // every kernel the cpu supports, not only the one apply_batch uses
+    for (const auto& kernel : dtree::supported_complete_leaves_kernels()) {
+        std::vector<std::uint32_t> kernel_slots(n);
+        kernel.find_leaves(tree.features().data(), tree.thresholds().data(),
+            tree.depth(), batch.column(0).data(), batch.stride(),
+            std::span { kernel_slots });
+        EXPECT_EQ(kernel_slots, slots) << kernel.name;
+    }
+
+    EXPECT_THROW(
+        tree.apply_batch(batch, std::span { out.data(), n }), std::runtime_error);
+    EXPECT_THROW(tree.apply_batch(make_random_dataset(2, n, 3u), std::span { slots }),
+        std::runtime_error);
+}
+
+TEST(test_complete_tree, test_binary_matches_flat_tree)
+{
+    auto train = make_random_dataset(3, 2000, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 6u, 1u, 1.0 },
+        dtree::algos::basic_optimal_split<2> {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 2));
+
+    dtree::complete_tree tree { flat };
+
+    std::size_t n = 100;
+    auto batch = make_random_dataset(3, n, 2u);
+    std::vector<double> out(n);
+    tree.apply_batch(batch, std::span { out });
+    for (std::size_t i = 0; i < n; ++i)
+        EXPECT_EQ(out[i], flat.apply(sample_of(batch, i)));
+}
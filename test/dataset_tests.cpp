@@ -0,0 +1,78 @@
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/dataset.h"
+
+TEST(test_dataset, test_from_feature_set)
+{
+    std::unordered_map<std::size_t, std::vector<double>> features {
+        { 1, { 0.5, 0.25, 1.5 } },
+        { 0, { 1.0, 2.0, 3.0 } },
+    };
+
+    dtree::dataset data { features };
+
+    static_assert(dtree::single_numeric_feature_set_c<dtree::dataset>);
+    ASSERT_EQ(data.size(), 2u);
+    EXPECT_EQ(data.number_of_samples(), 3u);
+
+    std::size_t expected_id = 0;
+    for (const auto& [feature_id, feature] : data) {
+        EXPECT_EQ(feature_id, expected_id++);
+        EXPECT_EQ(std::vector<double>(begin(feature), end(feature)),
+            features.at(feature_id));
+    }
+
+    const auto& feature = data.find(1)->second;
+    EXPECT_EQ(std::vector<double>(begin(feature), end(feature)),
+        std::vector<double>({ 0.5, 0.25, 1.5 }));
+    EXPECT_EQ(data.find(2), data.end());
+}
+
+TEST(test_dataset, test_select)
+{
+    std::unordered_map<std::size_t, std::vector<double>> features {
+        { 0, { 1.0, 2.0, 3.0, 4.0 } },
+        { 1, { 0.5, 0.25, 1.5, 0.75 } },
+    };
+
+    dtree::dataset data { features };
+    std::vector<std::size_t> index { 3, 0, 2 };
+    auto selected = data.select(index);
+
+    ASSERT_EQ(selected.size(), 2u);
+    EXPECT_EQ(selected.number_of_samples(), 3u);
+    auto feature = selected.column(1);
+    EXPECT_EQ(std::vector<double>(begin(feature), end(feature)),
+        std::vector<double>({ 0.75, 0.5, 1.5 }));
+}
+
+TEST(test_dataset, test_columns_are_aligned)
+{
+    dtree::float_dataset data { 3, 17 };
+
+    for (const auto& [feature_id, feature] : data) {
+        EXPECT_EQ(feature.size(), 17u);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(feature.data()) % 64, 0u);
+    }
+
+    data.column(2)[16] = 1.5f;
+    dtree::float_dataset copy { data };
+    EXPECT_EQ(copy.at(2)[16], 1.5f);
+    EXPECT_NE(copy.at(2).data(), data.at(2).data());
+}
+
+TEST(test_dataset, test_ids_must_be_dense)
+{
+    std::unordered_map<std::size_t, std::vector<double>> features {
+        { 0, { 1.0, 2.0 } },
+        { 2, { 3.0, 4.0 } },
+    };
+
+    EXPECT_THROW(dtree::dataset { features }, std::runtime_error);
+    EXPECT_THROW(dtree::dataset {}.at(0), std::out_of_range);
+}
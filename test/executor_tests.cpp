@@ -0,0 +1,98 @@
+
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/executor.h"
+
+namespace {
+
+std::size_t parallel_sum(dtree::executor& executor, std::size_t first, std::size_t last)
+{
+    if (last - first <= 8) {
+        std::size_t sum = 0;
+        for (std::size_t i = first; i < last; ++i)
+            sum += i;
+        return sum;
+    }
+
+    std::size_t middle = first + (last - first) / 2;
+    std::size_t lower_sum = 0, upper_sum = 0;
+    executor.invoke(
+        [&]() { lower_sum = parallel_sum(executor, first, middle); },
+        [&]() { upper_sum = parallel_sum(executor, middle, last); });
+    return lower_sum + upper_sum;
+}
+
+} // namespace
+
+TEST(test_work_stealing_pool, test_invoke)
+{
+    dtree::work_stealing_pool pool { 4 };
+    EXPECT_EQ(pool.concurrency(), 4u);
+
+    bool lower = false, upper = false;
+    pool.invoke([&]() { lower = true; }, [&]() { upper = true; });
+
+    EXPECT_TRUE(lower);
+    EXPECT_TRUE(upper);
+}
+
+TEST(test_work_stealing_pool, test_nested_invoke)
+{
+    dtree::work_stealing_pool pool { 4 };
+
+    EXPECT_EQ(parallel_sum(pool, 0, 100'000), std::size_t { 100'000 } * 99'999 / 2);
+}
+
+TEST(test_work_stealing_pool, test_parallel_for)
+{
+    dtree::work_stealing_pool pool { 4 };
+
+    std::vector<std::size_t> squares(1000);
+    pool.parallel_for(squares.size(), [&squares](std::size_t i) { squares[i] = i * i; });
+    for (std::size_t i = 0; i < squares.size(); ++i)
+        EXPECT_EQ(squares[i], i * i);
+
+    bool ran = false;
+    pool.parallel_for(0, [&ran](std::size_t) { ran = true; });
+    EXPECT_FALSE(ran);
+}
+
+TEST(test_work_stealing_pool, test_thread_count_is_bounded)
+{
+    dtree::work_stealing_pool pool { 2 };
+
+    std::mutex mutex;
+    std::set<std::thread::id> ids;
+    std::function<void(int)> recurse = [&](int depth) {
+        {
+            std::lock_guard lock { mutex };
+            ids.insert(std::this_thread::get_id());
+        }
+        if (depth > 0)
+            pool.invoke([&]() { recurse(depth - 1); }, [&]() { recurse(depth - 1); });
+    };
+    recurse(10);
+
+    // the pool's workers and the calling thread
+    EXPECT_LE(ids.size(), 3u);
+}
+
+TEST(test_work_stealing_pool, test_exceptions_are_rethrown)
+{
+    dtree::work_stealing_pool pool { 2 };
+
+    std::atomic<bool> lower_ran = false;
+    EXPECT_THROW(pool.invoke([&]() { lower_ran = true; },
+                     []() { throw std::runtime_error { "upper failed" }; }),
+        std::runtime_error);
+    EXPECT_TRUE(lower_ran);
+
+    EXPECT_THROW(
+        pool.invoke([]() { throw std::runtime_error { "lower failed" }; }, []() {}),
+        std::runtime_error);
+}
@@ -1,10 +1,18 @@
+#include <cmath>
+#include <random>
+#include <vector>
 
 #include <gmock/gmock-matchers.h>
 #include <gtest/gtest.h>
 
+#include "dtree/algos/single_numeric.h"
 #include "dtree/flat_tree.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/tree_builder.h"
 #include "dtree/types.h"
 
+#include "test_utils.h"
+
 struct test_splitting {
     template <typename T> bool operator()(const T& t) const { return t <= 0; }
 };
@@ -50,6 +58,128 @@ TEST(test_flat_tree, test_apply)
         ::testing::ElementsAreArray({ 0.66, 0.12, 0.22 }));
 }
 
+namespace {
+
+using dtree::tests::make_labels;
+using dtree::tests::make_random_features;
+using dtree::tests::sample_of;
+
+} // namespace
+
+TEST(test_flat_tree, test_apply_batch)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 7u, 1u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    auto tree = builder.build(train, make_labels(train, 3));
+
+    // several samples at most of the leaves
+    auto batch = make_random_features(3, 1000, 2u);
+    std::vector<double> out(3 * 1000);
+    tree.apply_batch(batch, std::span { out });
+
+    std::vector<std::size_t> leaves(1000);
+    tree.apply_batch(batch, std::span { leaves });
+
+    for (std::size_t i = 0; i < 1000; ++i) {
+        const auto& expected = tree.apply(sample_of(batch, i));
+        std::vector<double> row(out.begin() + 3 * i, out.begin() + 3 * (i + 1));
+        row.resize(expected.size());
+        EXPECT_EQ(row, expected);
+        EXPECT_EQ(std::get<dtree::leaf>(tree[leaves[i]]).value(), expected);
+    }
+
+    EXPECT_THROW(tree.apply_batch(batch, std::span { out.data(), 2500 }),
+        std::runtime_error);
+
+    // a batch missing a feature the tree splits on
+    for (std::size_t feature_id = 0; feature_id < 3; ++feature_id) {
+        auto partial = batch;
+        partial.erase(feature_id);
+        EXPECT_THROW(tree.apply_batch(partial, std::span { leaves }), std::runtime_error)
+            << feature_id;
+
+        // the check comes before any value is written
+        auto written = out;
+        EXPECT_THROW(tree.apply_batch(partial, std::span { out }), std::runtime_error);
+        EXPECT_EQ(out, written) << feature_id;
+    }
+}
+
+TEST(test_flat_tree, test_apply_batch_deep)
+{
+    using node_type = dtree::node<dtree::single_numeric_splitting>;
+
+    // a complete tree of random splits, its nodes well over the L2 cache, so samples
+    // are partitioned down many levels, and a batch over several chunks
+    std::size_t depth = 14;
+    dtree::flat_tree<node_type> tree { depth };
+    std::mt19937 gen { 1u };
+    std::normal_distribution<double> t_dist;
+    std::uniform_int_distribution<std::size_t> f_dist { 0, 2 };
+    for (std::size_t loc = 0; loc < tree.data().size(); ++loc) {
+        if (dtree::flat_tree<node_type>::get_depth(loc) < depth)
+            tree[loc] = node_type { f_dist(gen), { 0.5 * t_dist(gen) } };
+        else
+            tree[loc] = dtree::leaf { { 0.5, 0.5 * std::abs(t_dist(gen)) } };
+    }
+
+    std::size_t n = 10'000;
+    auto batch = make_random_features(3, n, 2u);
+    std::vector<double> out(3 * n);
+    tree.apply_batch(batch, std::span { out });
+
+    std::vector<std::size_t> leaves(n);
+    tree.apply_batch(batch, std::span { leaves });
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const auto& expected = tree.apply(sample_of(batch, i));
+        std::vector<double> row(out.begin() + 3 * i, out.begin() + 3 * (i + 1));
+        row.resize(expected.size());
+        EXPECT_EQ(row, expected);
+        EXPECT_EQ(std::get<dtree::leaf>(tree[leaves[i]]).value(), expected);
+    }
+}
+
+TEST(test_flat_tree, test_apply_batch_checks_features)
+{
+    using node_type = dtree::node<dtree::single_numeric_splitting>;
+
+    dtree::flat_tree<node_type> tree { 2 };
+    tree[0] = node_type { 0u, { 0.0 } };
+    tree[1] = dtree::leaf { { 1.0 } };
+    tree[2] = dtree::leaf { { 0.0, 1.0 } };
+
+    // a batch may lack the features the tree doesn't split on
+    dtree::tests::feature_set_t batch { { 0, { -1.0, 1.0 } }, { 2, { 0.0, 0.0 } } };
+    std::vector<std::size_t> leaves(2);
+    tree.apply_batch(batch, std::span { leaves });
+    EXPECT_EQ(leaves, (std::vector<std::size_t> { 1u, 2u }));
+
+    // the check sees a split made through a reference taken before the last batch
+    auto& node = tree[2];
+    tree[5] = dtree::leaf { { 1.0 } };
+    tree[6] = dtree::leaf { { 0.0, 1.0 } };
+    tree.apply_batch(batch, std::span { leaves });
+    node = node_type { 1u, { 0.0 } };
+    EXPECT_THROW(tree.apply_batch(batch, std::span { leaves }), std::runtime_error);
+}
+
+TEST(test_flat_tree, test_apply_batch_binary)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 7u, 1u, 1.0 },
+        dtree::algos::basic_optimal_split<2> {}, dtree::gini_index };
+    auto tree = builder.build(train, make_labels(train, 2));
+
+    auto batch = make_random_features(3, 1000, 2u);
+    std::vector<double> out(1000);
+    tree.apply_batch(batch, std::span { out });
+
+    for (std::size_t i = 0; i < 1000; ++i)
+        EXPECT_EQ(out[i], tree.apply(sample_of(batch, i)));
+}
+
 TEST(test_flat_tree, test_get_depth)
 {
     EXPECT_EQ(test_flat_tree_t::get_depth(0), 0);
@@ -1,6 +1,12 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <tuple>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include "dtree/concepts.h"
 #include "dtree/impurity_measures.h"
 
 struct impurity_measures_test_data {
@@ -22,3 +28,110 @@ INSTANTIATE_TEST_CASE_P(test_impurity_measures, impurity_measures_fixture,
     ::testing::Values(impurity_measures_test_data { dtree::gini_index, { 4, 6 }, 0.48 },
         impurity_measures_test_data {
             dtree::entropy, { 25, 67 }, 0.84394912448050341 }));
+
+template <typename impurity_t> void check_accumulator(impurity_t impurity)
+{
+    dtree::label_counts counts { 3, 0, 7, 1 };
+    auto accumulator = impurity.accumulate(counts);
+    EXPECT_DOUBLE_EQ(accumulator.cost(), impurity(counts));
+
+    for (auto [label, count, add] : { std::tuple { 1u, 4u, true },
+             std::tuple { 2u, 5u, false }, std::tuple { 0u, 1u, true },
+             std::tuple { 3u, 1u, false } }) {
+        if (add) {
+            accumulator.add(label, count);
+            counts[label] += count;
+        } else {
+            accumulator.remove(label, count);
+            counts[label] -= count;
+        }
+        EXPECT_DOUBLE_EQ(accumulator.cost(), impurity(counts));
+    }
+
+    // a long scan over skewed counts, moving the samples of a node one at a time from
+    // the upper side of a split to the lower one, where the costs are small and a
+    // running sum would drift from the counts it stands for
+    dtree::label_counts lower(4);
+    dtree::label_counts upper { 100'000, 300, 20, 1 };
+    std::vector<std::size_t> scan;
+    for (std::size_t label = 0; label < upper.size(); ++label)
+        scan.insert(scan.end(), upper[label], label);
+    std::shuffle(scan.begin(), scan.end(), std::mt19937 { 1u });
+
+    auto lower_accumulator = impurity.accumulate(lower);
+    auto upper_accumulator = impurity.accumulate(upper);
+    for (std::size_t label : scan) {
+        lower_accumulator.add(label);
+        ++lower[label];
+        upper_accumulator.remove(label);
+        --upper[label];
+        ASSERT_DOUBLE_EQ(lower_accumulator.cost(), impurity(lower));
+        ASSERT_DOUBLE_EQ(upper_accumulator.cost(), impurity(upper));
+    }
+}
+
+TEST(test_impurity_measures, test_incremental_gini)
+{
+    static_assert(dtree::incremental_cost_fn_c<dtree::gini_impurity>);
+    static_assert(!dtree::incremental_cost_fn_c<decltype(&dtree::gini_index)>);
+    check_accumulator(dtree::gini_impurity {});
+}
+
+TEST(test_impurity_measures, test_incremental_entropy)
+{
+    static_assert(dtree::incremental_cost_fn_c<dtree::entropy_impurity>);
+    check_accumulator(dtree::entropy_impurity {});
+}
+
+TEST(test_impurity_measures, test_many_classes)
+{
+    // the vectorised sums against the definitions, over lengths covering the tails of
+    // each kernel and counts on both sides of the c log2(c) table
+    for (std::size_t n_classes : { 2u, 3u, 5u, 8u, 13u, 100u, 1000u }) {
+        dtree::label_counts counts(n_classes);
+        for (std::size_t i = 0; i < n_classes; ++i)
+            counts[i] = (i * 7919u) % 5000u;
+
+        double total = 0.0;
+        for (std::size_t c : counts)
+            total += c;
+
+        double gini = 1.0;
+        double entropy = 0.0;
+        for (std::size_t c : counts) {
+            double p = c / total;
+            gini -= p * p;
+            if (c > 0)
+                entropy -= p * std::log2(p);
+        }
+
+        EXPECT_NEAR(dtree::gini_index(counts), gini, 1e-12) << n_classes;
+        EXPECT_NEAR(dtree::entropy(counts), entropy, 1e-9) << n_classes;
+
+        // every kernel the cpu supports, not only the one the measures use
+        double sum_squares = 0.0;
+        double sum_c_log2_c = 0.0;
+        for (std::size_t c : counts) {
+            sum_squares += static_cast<double>(c) * c;
+            if (c > 0)
+                sum_c_log2_c += c * std::log2(static_cast<double>(c));
+        }
+        for (const auto& kernels : dtree::supported_impurity_kernels()) {
+            auto squares = kernels.sum_squares(counts.data(), counts.size());
+            EXPECT_EQ(squares.total, total) << kernels.name << " " << n_classes;
+            EXPECT_NEAR(squares.sum, sum_squares, 1e-12 * sum_squares)
+                << kernels.name << " " << n_classes;
+
+            auto c_log2_c = kernels.sum_c_log2_c(counts.data(), counts.size());
+            EXPECT_EQ(c_log2_c.total, total) << kernels.name << " " << n_classes;
+            EXPECT_NEAR(c_log2_c.sum, sum_c_log2_c, 1e-12 * sum_c_log2_c)
+                << kernels.name << " " << n_classes;
+        }
+    }
+}
+
+TEST(test_impurity_measures, test_no_samples)
+{
+    EXPECT_EQ(dtree::gini_index({ 0, 0, 0 }), 0.0);
+    EXPECT_EQ(dtree::entropy({}), 0.0);
+}
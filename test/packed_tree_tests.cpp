@@ -0,0 +1,155 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/algos/single_numeric.h"
+#include "dtree/impurity_measures.h"
+#include "dtree/packed_tree.h"
+#include "dtree/tree_builder.h"
+#include "dtree/types.h"
+
+#include "test_utils.h"
+
+namespace {
+
+using node_type = dtree::node<dtree::single_numeric_splitting>;
+
+using dtree::tests::make_labels;
+using dtree::tests::make_random_features;
+using dtree::tests::sample_of;
+
+} // namespace
+
+TEST(test_packed_tree, test_bin)
+{
+    dtree::flat_tree<node_type> flat { 2 };
+    flat[0] = node_type { 1u, { 0.5 } };
+    flat[1] = node_type { 1u, { -0.5 } };
+    flat[2] = node_type { 0u, { 2.0 } };
+    flat[3] = dtree::leaf { { 1.0, 0.0 } };
+    flat[4] = dtree::leaf { { 0.5, 0.5 } };
+    flat[5] = dtree::leaf { { 0.0, 1.0 } };
+    flat[6] = dtree::leaf { { 0.25, 0.75 } };
+
+    dtree::packed_tree tree { flat };
+    EXPECT_EQ(sizeof(tree[0]), 8u);
+    EXPECT_EQ(tree.size(), 7u);
+    EXPECT_EQ(tree.number_of_features(), 2u);
+    EXPECT_EQ(tree.cuts().cuts(), (std::vector { 2.0, -0.5, 0.5 }));
+
+    EXPECT_EQ(tree.cuts().bin(1u, -1.0), 0u);
+    EXPECT_EQ(tree.cuts().bin(1u, -0.5), 0u);
+    EXPECT_EQ(tree.cuts().bin(1u, 0.0), 1u);
+    EXPECT_EQ(tree.cuts().bin(1u, 0.5), 1u);
+    EXPECT_EQ(tree.cuts().bin(1u, 0.6), 2u);
+    EXPECT_EQ(tree.cuts().bin(1u, std::numeric_limits<double>::quiet_NaN()), 2u);
+
+    EXPECT_EQ(tree[0].threshold, 1u);
+    EXPECT_EQ(tree[1].threshold, 0u);
+
+    // the thresholds themselves go to the lower child, as with the flat_tree
+    std::vector<dtree::packed_tree<>::code_type> codes(tree.number_of_features());
+    EXPECT_EQ(tree.apply(std::vector { 0.0, -0.5 }, codes)[0], 1.0f);
+    EXPECT_EQ(tree.apply(std::vector { 0.0, 0.5 }, codes)[0], 0.5f);
+    EXPECT_EQ(tree.apply(std::vector { 2.0, 0.6 }, codes)[0], 0.0f);
+    EXPECT_EQ(tree.apply(std::vector { 2.1, 0.6 }, codes)[0], 0.25f);
+    // NaN fails every x <= t so takes the upper child
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_EQ(tree.apply(std::vector { nan, nan }, codes)[0], 0.25f);
+}
+
+TEST(test_packed_tree, test_matches_flat_tree)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 12u, 1u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 3));
+
+    dtree::packed_tree tree { flat };
+
+    auto test = make_random_features(3, 1000, 2u);
+    std::vector<dtree::packed_tree<>::code_type> codes(tree.number_of_features());
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        tree.cuts().bin_sample(sample, codes);
+
+        const auto& expected = flat.apply(sample);
+        auto value = tree.apply_binned(codes);
+        ASSERT_EQ(value.size(), 3u);
+        for (std::size_t label = 0; label < expected.size(); ++label)
+            EXPECT_FLOAT_EQ(value[label], expected[label]);
+    }
+}
+
+TEST(test_packed_tree, test_binary_matches_flat_tree)
+{
+    auto train = make_random_features(3, 500, 1u);
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 7u, 1u, 1.0 },
+        dtree::algos::basic_optimal_split<2> {}, dtree::gini_index };
+    auto flat = builder.build(train, make_labels(train, 2));
+
+    dtree::packed_tree tree { flat };
+    EXPECT_TRUE(tree.values().empty());
+
+    auto test = make_random_features(3, 1000, 2u);
+    std::vector<dtree::packed_tree<>::code_type> codes(tree.number_of_features());
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        EXPECT_FLOAT_EQ(tree.apply(sample, codes), flat.apply(sample));
+    }
+}
+
+TEST(test_packed_tree, test_feature_id_out_of_range)
+{
+    dtree::flat_tree<node_type> flat { 1 };
+    flat[0] = node_type { 70'000u, { 0.5 } };
+    flat[1] = dtree::leaf { { 1.0 } };
+    flat[2] = dtree::leaf { { 1.0 } };
+
+    EXPECT_THROW(dtree::packed_tree { flat }, std::runtime_error);
+}
+
+TEST(test_packed_tree, test_shared_cuts)
+{
+    dtree::tree_builder builder { dtree::tree_builder_config { false, 0u, 8u, 1u, 1.0 },
+        dtree::algos::optimal_split {}, dtree::gini_index };
+    std::vector<dtree::flat_tree<node_type>> flats;
+    for (std::size_t seed : { 1u, 3u }) {
+        auto train = make_random_features(3, 500, seed);
+        flats.push_back(builder.build(train, make_labels(train, 3)));
+    }
+
+    auto cuts = dtree::make_packed_cuts(flats);
+    std::vector<dtree::packed_tree<>> trees;
+    for (const auto& flat : flats)
+        trees.emplace_back(flat, cuts);
+    EXPECT_EQ(trees[0].shared_cuts(), trees[1].shared_cuts());
+
+    // a sample binned once against the shared cuts is applied to every tree
+    auto test = make_random_features(3, 1000, 2u);
+    std::vector<dtree::packed_tree<>::code_type> codes(cuts->number_of_features());
+    for (std::size_t i = 0; i < 1000; ++i) {
+        auto sample = sample_of(test, i);
+        cuts->bin_sample(sample, codes);
+        for (std::size_t t = 0; t < trees.size(); ++t) {
+            const auto& expected = flats[t].apply(sample);
+            auto value = trees[t].apply_binned(codes);
+            for (std::size_t label = 0; label < expected.size(); ++label)
+                EXPECT_FLOAT_EQ(value[label], expected[label]);
+        }
+    }
+}
+
+TEST(test_packed_tree, test_threshold_not_a_cut)
+{
+    dtree::flat_tree<node_type> flat { 1 };
+    flat[0] = node_type { 0u, { 0.5 } };
+    flat[1] = dtree::leaf { { 1.0 } };
+    flat[2] = dtree::leaf { { 1.0 } };
+
+    auto cuts = std::make_shared<const dtree::packed_cuts>(
+        std::vector<std::vector<double>> { { 0.25, 0.75 } });
+    EXPECT_THROW((dtree::packed_tree { flat, cuts }), std::runtime_error);
+}
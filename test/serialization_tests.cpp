@@ -91,12 +91,24 @@ TEST(test_serialization, test_string_length_splitting)
     check_serialization(splitting);
 }
 
+TEST(test_serialization, test_category_splitting)
+{
+    dtree::category_splitting splitting { { 0b1010u, 0u, 0x8000000000000001u } };
+    check_serialization(splitting);
+}
+
 TEST(test_serialization, test_leaf)
 {
     dtree::leaf l { dtree::label_distribution { 0.2, 0.15, 0.15, 0.5 } };
     check_serialization(l);
 }
 
+TEST(test_serialization, test_binary_leaf)
+{
+    dtree::binary_leaf l { 0.35 };
+    check_serialization(l);
+}
+
 TEST(test_serialization, test_flat_tree_one_dimensional)
 {
     using namespace dtree;
@@ -106,3 +118,60 @@ TEST(test_serialization, test_flat_tree_one_dimensional)
     t[10] = leaf { label_distribution { 0.2, 0.15, 0.15, 0.5 } };
     check_serialization(t);
 }
+
+TEST(test_serialization, test_binary_flat_tree)
+{
+    using namespace dtree;
+    using node_type = node<single_numeric_splitting>;
+    flat_tree<node_type, binary_leaf> t(2);
+    t[0] = node_type { 3, { 0.67 } };
+    t[1] = binary_leaf { 0.25 };
+    t[2] = binary_leaf { 0.75 };
+    check_serialization(t);
+}
+
+TEST(test_serialization, test_compact_tree)
+{
+    using namespace dtree;
+    using node_type = node<single_numeric_splitting>;
+    flat_tree<node_type> t(1);
+    t[0] = node_type { 3, { 0.67 } };
+    t[1] = leaf { label_distribution { 0.2, 0.8 } };
+    t[2] = leaf { label_distribution { 0.6, 0.3, 0.1 } };
+    check_serialization(compact_tree<node_type> { t });
+}
+
+TEST(test_serialization, test_compact_tree_pooled_splittings)
+{
+    using namespace dtree;
+    using node_type = node<multi_numeric_splitting>;
+    flat_tree<node_type, binary_leaf> t(1);
+    t[0] = node_type { 3, { { 0.8, 0.6 }, 0.9 } };
+    t[1] = binary_leaf { 0.25 };
+    t[2] = binary_leaf { 0.75 };
+    check_serialization(compact_tree<node_type, binary_leaf> { t });
+}
+
+TEST(test_serialization, test_packed_tree)
+{
+    using namespace dtree;
+    using node_type = node<single_numeric_splitting>;
+    flat_tree<node_type> t(2);
+    t[0] = node_type { 3, { 0.67 } };
+    t[1] = node_type { 1, { -0.2 } };
+    t[2] = leaf { label_distribution { 0.2, 0.8 } };
+    t[3] = leaf { label_distribution { 0.6, 0.3, 0.1 } };
+    t[4] = leaf { label_distribution { 1.0 } };
+    check_serialization(packed_tree { t });
+}
+
+TEST(test_serialization, test_binary_packed_tree)
+{
+    using namespace dtree;
+    using node_type = node<single_numeric_splitting>;
+    flat_tree<node_type, binary_leaf> t(1);
+    t[0] = node_type { 3, { 0.67 } };
+    t[1] = binary_leaf { 0.25 };
+    t[2] = binary_leaf { 0.75 };
+    check_serialization(packed_tree { t });
+}
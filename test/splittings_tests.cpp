@@ -90,3 +90,17 @@ INSTANTIATE_TEST_CASE_P(test_splitting_variant, splitting_variant_fixture,
         splitting_variant_test_data {
             dtree::multi_numeric_splitting { { 0.4, 0.5, 1.4 }, 0.7 },
             std::array { 0.6, -0.5, 0.8 }, false }));
+
+TEST(test_category_splitting, test_splitting)
+{
+    // categories 1, 3 and 64
+    dtree::category_splitting splitting { { 0b1010u, 0b1u } };
+
+    EXPECT_TRUE(splitting(dtree::category { 1u }));
+    EXPECT_TRUE(splitting(dtree::category { 3u }));
+    EXPECT_TRUE(splitting(dtree::category { 64u }));
+    EXPECT_FALSE(splitting(dtree::category { 0u }));
+    EXPECT_FALSE(splitting(dtree::category { 65u }));
+    EXPECT_FALSE(splitting(dtree::category { 128u }));
+    EXPECT_FALSE(splitting(dtree::category { UINT32_MAX }));
+}
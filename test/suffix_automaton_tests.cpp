@@ -0,0 +1,103 @@
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "dtree/suffix_automaton.h"
+
+namespace {
+
+std::uint32_t read(const dtree::suffix_automaton& automaton, std::string_view text)
+{
+    std::uint32_t state = 0;
+    for (unsigned char c : text) {
+        state = automaton.next(state, c);
+        if (state == dtree::suffix_automaton::no_state)
+            break;
+    }
+    return state;
+}
+
+std::vector<std::string> random_texts(std::size_t n)
+{
+    std::mt19937 gen {};
+    std::uniform_int_distribution<int> c_dist { 'a', 'c' };
+    std::uniform_int_distribution<std::size_t> length_dist { 0, 12 };
+
+    std::vector<std::string> texts;
+    for (std::size_t i = 0; i < n; ++i) {
+        std::string text;
+        for (std::size_t j = length_dist(gen); j > 0; --j)
+            text.push_back(static_cast<char>(c_dist(gen)));
+        texts.push_back(text);
+    }
+    return texts;
+}
+
+} // namespace
+
+TEST(test_suffix_automaton, test_substrings)
+{
+    auto texts = random_texts(20);
+
+    dtree::suffix_automaton automaton;
+    std::set<std::string> substrings;
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+        automaton.add(texts[i], i);
+        for (std::size_t first = 0; first < texts[i].size(); ++first) {
+            for (std::size_t last = first + 1; last <= texts[i].size(); ++last)
+                substrings.insert(texts[i].substr(first, last - first));
+        }
+    }
+
+    // each state holds the substrings between its length and its link's
+    std::size_t n_substrings = 0;
+    for (std::uint32_t state = 1; state < automaton.number_of_states(); ++state) {
+        n_substrings
+            += automaton.length(state) - automaton.length(automaton.link(state));
+    }
+    EXPECT_EQ(n_substrings, substrings.size());
+    EXPECT_LT(automaton.number_of_states(), 2 * substrings.size() + 2);
+
+    for (const auto& substring : substrings) {
+        std::uint32_t state = read(automaton, substring);
+        ASSERT_NE(state, dtree::suffix_automaton::no_state);
+        EXPECT_LE(substring.size(), automaton.length(state));
+        EXPECT_GT(substring.size(), automaton.length(automaton.link(state)));
+
+        auto [id, end] = automaton.end(state);
+        ASSERT_LT(id, texts.size());
+        ASSERT_GE(end + 1, substring.size());
+        EXPECT_EQ(texts[id].substr(end + 1 - substring.size(), substring.size()),
+            substring);
+    }
+
+    EXPECT_EQ(read(automaton, "abcabcabcabcabc"), dtree::suffix_automaton::no_state);
+}
+
+TEST(test_suffix_automaton, test_for_each_state)
+{
+    auto texts = random_texts(20);
+
+    dtree::suffix_automaton automaton;
+    for (std::size_t i = 0; i < texts.size(); ++i)
+        automaton.add(texts[i], i);
+
+    std::vector<std::uint32_t> visited(automaton.number_of_states(), 0u);
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+        std::set<std::uint32_t> expected;
+        for (std::size_t first = 0; first < texts[i].size(); ++first) {
+            for (std::size_t last = first + 1; last <= texts[i].size(); ++last)
+                expected.insert(read(automaton, texts[i].substr(first, last - first)));
+        }
+
+        std::vector<std::uint32_t> states;
+        automaton.for_each_state(texts[i], visited, static_cast<std::uint32_t>(i + 1),
+            [&states](std::uint32_t state) { states.push_back(state); });
+
+        EXPECT_EQ(states.size(), expected.size());
+        EXPECT_EQ(std::set<std::uint32_t>(begin(states), end(states)), expected);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "dtree/dataset.h"
+#include "dtree/labels.h"
+
+namespace dtree::tests {
+
+using feature_set_t = std::unordered_map<std::size_t, std::vector<double>>;
+
+/// Features 0, ..., n_features - 1 of n_samples normally distributed values each.
+inline feature_set_t make_random_features(
+    std::size_t n_features, std::size_t n_samples, unsigned seed)
+{
+    std::mt19937 gen { seed };
+    std::normal_distribution<double> dist;
+
+    feature_set_t features;
+    for (std::size_t id = 0; id < n_features; ++id) {
+        std::vector<double> feature(n_samples);
+        for (auto& x : feature)
+            x = dist(gen);
+        features.emplace(id, std::move(feature));
+    }
+    return features;
+}
+
+/// The features of make_random_features as the columns of a dataset.
+inline dataset make_random_dataset(
+    std::size_t n_features, std::size_t n_samples, unsigned seed)
+{
+    return dataset { make_random_features(n_features, n_samples, seed) };
+}
+
+/// n_samples labels drawn uniformly from 0, ..., n_labels - 1, unrelated to any
+/// features.
+inline labels make_random_labels(
+    std::size_t n_samples, std::size_t n_labels, unsigned seed)
+{
+    std::mt19937 gen { seed };
+    std::uniform_int_distribution<std::size_t> dist { 0, n_labels - 1 };
+
+    labels out;
+    for (std::size_t i = 0; i < n_samples; ++i)
+        out.push_back(static_cast<labels::label_t>(dist(gen)));
+    return out;
+}
+
+/// Labels that a tree can learn from features 0, 1 and 2 of the samples, held as a
+/// feature_set_t or a dataset.
+template <typename feature_set>
+labels make_labels(const feature_set& features, std::size_t n_labels)
+{
+    labels out;
+    for (std::size_t i = 0; i < features.at(0).size(); ++i) {
+        double x = features.at(0)[i] + features.at(1)[i] * features.at(2)[i];
+        out.push_back(static_cast<std::size_t>(std::abs(x) * 2) % n_labels);
+    }
+    return out;
+}
+
+/// The values of sample i of a feature_set_t or a dataset, indexed by feature id.
+template <typename feature_set>
+std::vector<double> sample_of(const feature_set& features, std::size_t i)
+{
+    std::vector<double> sample(features.size());
+    for (const auto& [id, feature] : features)
+        sample[id] = feature[i];
+    return sample;
+}
+
+} // namespace dtree::tests
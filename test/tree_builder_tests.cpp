@@ -1,5 +1,7 @@
 
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <valarray>
 
 #include <boost/archive/xml_oarchive.hpp>
@@ -7,14 +9,18 @@
 #include <gtest/gtest.h>
 #include <spdlog/spdlog.h>
 
+#include "dtree/algos/categorical.h"
 #include "dtree/algos/mixed_algo.h"
 #include "dtree/algos/multi_numeric.h"
 #include "dtree/algos/single_numeric.h"
 #include "dtree/algos/strings.h"
 #include "dtree/flat_tree.h"
 #include "dtree/impurity_measures.h"
+#include "dtree/level_wise_tree_builder.h"
 #include "dtree/tree_builder.h"
 
+#include "test_utils.h"
+
 // FIXME - make all this nicer
 namespace dtree::tests {
 
@@ -141,6 +147,415 @@ TEST(tree_builder_tests, test_build_with_user_defined_cost)
     tests::check_equal(tree, expected_tree);
 }
 
+TEST(tree_builder_tests, test_presorted_build)
+{
+    using namespace dtree;
+
+    using feature_set = std::unordered_map<std::size_t, std::vector<double>>;
+
+    feature_set test_features
+        = { { 0, { 1.0, 0.5, 1.5, 0.5, 1.2, 0.9, 0.4, 1.8, 2.1, 7.2, 0.5, 0.4 } },
+              { 1, { 0.1, 0.4, 0.2, 0.1, 0.4, 0.5, 0.8, 0.9, 0.7, 0.6, 0.8, 0.1 } },
+              { 2, { 8.8, 1.3, 5.6, 1.4, 6.7, 7.8, 0.2, 0.7, 0.1, 1.0, 5.0, 9.9 } } };
+
+    dtree::labels test_labels { 0u, 1u, 1u, 0u, 0u, 1u, 0u, 1u, 1u, 0u, 0u, 1u };
+
+    for (bool async : { false, true }) {
+        tree_builder_config config { async, 0u, 3u, 1u, 1.0 };
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+        config.presort = true;
+        tree_builder presorted_builder { config, algos::optimal_split {}, gini_index };
+
+        tests::check_equal(presorted_builder.build(test_features, test_labels),
+            builder.build(test_features, test_labels));
+    }
+}
+
+TEST(tree_builder_tests, test_build_without_features)
+{
+    using namespace dtree;
+
+    std::unordered_map<std::size_t, std::vector<double>> no_features;
+    dtree::labels test_labels { 0u, 1u, 1u, 0u, 1u };
+
+    for (bool presort : { false, true }) {
+        tree_builder_config config { false, 0u, 3u, 1u, 1.0 };
+        config.presort = presort;
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+        auto tree = builder.build(no_features, test_labels);
+        ASSERT_TRUE(std::holds_alternative<leaf>(tree[0]));
+        tests::check_equal(std::get<leaf>(tree[0]), leaf { { 0.4, 0.6 } });
+    }
+
+    std::unordered_map<std::size_t, binned_feature> no_binned_features;
+    level_wise_tree_builder level_wise_builder { tree_builder_config { false, 0u, 3u,
+                                                     1u, 1.0 },
+        algos::histogram_split {}, gini_index };
+
+    auto tree = level_wise_builder.build(no_binned_features, test_labels);
+    ASSERT_TRUE(std::holds_alternative<leaf>(tree[0]));
+    tests::check_equal(std::get<leaf>(tree[0]), leaf { { 0.4, 0.6 } });
+}
+
+TEST(tree_builder_tests, test_histogram_build)
+{
+    using namespace dtree;
+
+    using feature_set = std::unordered_map<std::size_t, std::vector<double>>;
+
+    feature_set test_features
+        = { { 0, { 1.0, 0.5, 1.5, 0.5, 1.2, 0.9, 0.4, 1.8, 2.1, 7.2, 0.5, 0.4 } },
+              { 1, { 0.1, 0.4, 0.2, 0.1, 0.4, 0.5, 0.8, 0.9, 0.7, 0.6, 0.8, 0.1 } },
+              { 2, { 8.8, 1.3, 5.6, 0.4, 6.7, 7.8, 0.2, 0.7, 0.9, 1.0, 5.0, 9.9 } } };
+
+    std::unordered_map<std::size_t, binned_feature> binned_features;
+    for (const auto& [feature_id, feature] : test_features)
+        binned_features.emplace(feature_id, make_binned_feature(feature));
+
+    dtree::labels test_labels { 0u, 1u, 1u, 0u, 1u, 1u, 1u, 1u, 1u, 0u, 0u, 1u };
+
+    tree_builder_config config { false, 0u, 2u, 1u, 1.0 };
+    tree_builder builder { config, algos::optimal_split {}, gini_index };
+    tree_builder histogram_builder { config, algos::histogram_split {}, gini_index };
+
+    auto tree = builder.build(test_features, test_labels);
+    auto histogram_tree = histogram_builder.build(binned_features, test_labels);
+
+    for (std::size_t i = 0; i < test_labels.size(); ++i) {
+        std::array sample { test_features[0][i], test_features[1][i],
+            test_features[2][i] };
+        tests::check_equal(histogram_tree.apply(sample), tree.apply(sample));
+    }
+}
+
+TEST(tree_builder_tests, test_histogram_subtraction_build)
+{
+    using namespace dtree;
+
+    // histogram_split without split_histogram, so every node rescans its samples
+    struct scanning_split {
+        using splitting_type = single_numeric_splitting;
+        std::pair<double, splitting_type> operator()(const binned_feature& feature,
+            const labels& l, double (*cost_fn)(const label_counts&)) const
+        {
+            return algos::histogram_split {}(feature, l, cost_fn);
+        }
+    };
+
+    std::unordered_map<std::size_t, binned_feature> features;
+    for (const auto& [feature_id, feature] : tests::make_random_features(3, 500, 1u))
+        features.emplace(feature_id, make_binned_feature(feature, 32));
+
+    auto test_labels = tests::make_random_labels(500, 3, 2u);
+
+    for (bool async : { false, true }) {
+        tree_builder_config config { async, 0u, 5u, 10u, 0.9 };
+        tree_builder builder { config, scanning_split {}, gini_index };
+        tree_builder subtracting_builder { config, algos::histogram_split {},
+            gini_index };
+
+        tests::check_equal(subtracting_builder.build(features, test_labels),
+            builder.build(features, test_labels));
+    }
+}
+
+TEST(tree_builder_tests, test_level_wise_build)
+{
+    using namespace dtree;
+
+    std::unordered_map<std::size_t, binned_feature> features;
+    for (auto& [feature_id, feature] : tests::make_random_features(5, 1000, 1u)) {
+        for (auto& x : feature)
+            x = std::round(4.0 * x);
+        features.emplace(feature_id, make_binned_feature(feature, 16));
+    }
+
+    auto test_labels = tests::make_random_labels(1000, 3, 2u);
+
+    work_stealing_pool pool { 3 };
+
+    // a cap of one node's histograms sweeps each feature once per open node
+    for (auto [parallel_features, max_histogram_counts] :
+        { std::pair { false, std::size_t { 1 } << 22 },
+            std::pair { true, std::size_t { 1 } << 22 },
+            std::pair { false, std::size_t { 48 } } }) {
+        tree_builder_config config { false, 0u, 6u, 10u, 0.9 };
+        tree_builder builder { config, algos::histogram_split {}, gini_index };
+
+        config.parallel_features = parallel_features;
+        config.max_histogram_counts = max_histogram_counts;
+        config.executor_ = &pool;
+        level_wise_tree_builder level_wise_builder { config, algos::histogram_split {},
+            gini_index };
+
+        tests::check_equal(level_wise_builder.build(features, test_labels),
+            builder.build(features, test_labels));
+    }
+}
+
+TEST(tree_builder_tests, test_in_place_build)
+{
+    using namespace dtree;
+
+    using feature_set = std::unordered_map<std::size_t, std::vector<double>>;
+
+    feature_set test_features
+        = { { 0, { 1.0, 0.5, 1.5, 0.5, 1.2, 0.9, 0.4, 1.8, 2.1, 7.2, 0.5, 0.4 } },
+              { 1, { 0.1, 0.4, 0.2, 0.1, 0.4, 0.5, 0.8, 0.9, 0.7, 0.6, 0.8, 0.1 } },
+              { 2, { 8.8, 1.3, 5.6, 1.4, 6.7, 7.8, 0.2, 0.7, 0.1, 1.0, 5.0, 9.9 } } };
+
+    dtree::labels test_labels { 0u, 1u, 1u, 0u, 0u, 1u, 0u, 1u, 1u, 0u, 0u, 1u };
+
+    for (bool async : { false, true }) {
+        tree_builder_config config { async, 0u, 3u, 1u, 1.0 };
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+        config.in_place = true;
+        tree_builder in_place_builder { config, algos::optimal_split {}, gini_index };
+
+        tests::check_equal(in_place_builder.build(test_features, test_labels),
+            builder.build(test_features, test_labels));
+    }
+}
+
+TEST(tree_builder_tests, test_in_place_build_ties)
+{
+    using namespace dtree;
+
+    // deep nodes have few samples, so several features often split them perfectly
+    auto features = tests::make_random_features(4, 1000, 1u);
+    auto test_labels = tests::make_random_labels(1000, 2, 2u);
+
+    tree_builder_config config { false, 0u, 8u, 1u, 1.0 };
+    tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+    config.in_place = true;
+    tree_builder in_place_builder { config, algos::optimal_split {}, gini_index };
+
+    tests::check_equal(in_place_builder.build(features, test_labels),
+        builder.build(features, test_labels));
+}
+
+TEST(tree_builder_tests, test_in_place_build_with_mixed_features)
+{
+    using namespace dtree;
+
+    using mixed_feature_t
+        = std::variant<std::vector<double>, std::vector<std::valarray<double>>>;
+
+    std::unordered_map<std::size_t, mixed_feature_t> test_mixed_feature_set
+        = { { 0, std::vector<double> { 0.0, 0.4, 0.2, 0.7, 0.5, -0.7, 0.8 } },
+              { 1,
+                  std::vector<std::valarray<double>> { { 0.0, 0.5 }, { -0.1, 0.5 },
+                      { 0.8, 0.4 }, { -0.9, 1.3 }, { 2.3, -0.6 }, { -0.6, -0.9 },
+                      { 1.1, -0.1 } } } };
+
+    dtree::labels test_labels { 0u, 1u, 0u, 1u, 0u, 0u, 1u };
+
+    using algo_t = algos::mixed_algo<algos::optimal_split, algos::median_split,
+        algos::random_hyperplane_split<algos::optimal_split>>;
+
+    tree_builder_config config { false, 0u, 2u, 1u, 1.0 };
+    config.in_place = true;
+    tree_builder builder { config, algo_t {}, gini_index };
+
+    auto tree = builder.build(test_mixed_feature_set, test_labels);
+
+    using sample_t = std::variant<double, std::valarray<double>>;
+    const auto& feature_0 = std::get<0>(test_mixed_feature_set[0]);
+    const auto& feature_1 = std::get<1>(test_mixed_feature_set[1]);
+    for (std::size_t i = 0; i < test_labels.size(); ++i) {
+        std::array<sample_t, 2> sample { feature_0[i], feature_1[i] };
+        const auto& distribution = tree.apply(sample);
+        ASSERT_GT(distribution.size(), test_labels[i]);
+        EXPECT_GT(distribution[test_labels[i]], 0.0);
+    }
+}
+
+TEST(tree_builder_tests, test_build_from_dataset)
+{
+    using namespace dtree;
+
+    // float values so the float dataset holds exactly the same samples
+    auto features = tests::make_random_features(4, 500, 1u);
+    for (auto& [feature_id, feature] : features) {
+        for (auto& x : feature)
+            x = static_cast<float>(x);
+    }
+
+    auto test_labels = tests::make_random_labels(500, 3, 2u);
+
+    // in place or copying the samples of every node into a smaller dataset
+    for (auto [presort, in_place] : { std::pair { false, false },
+             std::pair { false, true }, std::pair { true, false } }) {
+        tree_builder_config config { false, 0u, 5u, 5u, 0.95 };
+        config.presort = presort;
+        config.in_place = in_place;
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+        auto expected_tree = builder.build(features, test_labels);
+        tests::check_equal(
+            builder.build(dataset { features }, test_labels), expected_tree);
+        tests::check_equal(
+            builder.build(float_dataset { features }, test_labels), expected_tree);
+    }
+}
+
+TEST(tree_builder_tests, test_build_with_compact_labels)
+{
+    using namespace dtree;
+
+    auto features = tests::make_random_features(3, 500, 1u);
+    std::unordered_map<std::size_t, binned_feature> binned_features;
+    for (const auto& [feature_id, feature] : features)
+        binned_features.emplace(feature_id, make_binned_feature(feature, 32));
+
+    auto test_labels = tests::make_random_labels(500, 10, 2u);
+    basic_labels<std::uint8_t> byte_labels;
+    basic_labels<std::uint16_t> short_labels;
+    for (auto label : test_labels) {
+        byte_labels.push_back(static_cast<std::uint8_t>(label));
+        short_labels.push_back(static_cast<std::uint16_t>(label));
+    }
+    EXPECT_EQ(byte_labels.get_label_counts(), test_labels.get_label_counts());
+
+    for (auto [presort, in_place] : { std::pair { false, false },
+             std::pair { true, false }, std::pair { false, true } }) {
+        tree_builder_config config { false, 0u, 4u, 5u, 0.95 };
+        config.presort = presort;
+        config.in_place = in_place;
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+
+        auto expected_tree = builder.build(features, test_labels);
+        tests::check_equal(builder.build(features, byte_labels), expected_tree);
+        tests::check_equal(builder.build(features, short_labels), expected_tree);
+    }
+
+    tree_builder_config config { false, 0u, 4u, 5u, 0.95 };
+    tree_builder builder { config, algos::histogram_split {}, gini_index };
+    level_wise_tree_builder level_wise_builder { config, algos::histogram_split {},
+        gini_index };
+
+    auto expected_tree = builder.build(binned_features, test_labels);
+    tests::check_equal(builder.build(binned_features, byte_labels), expected_tree);
+    tests::check_equal(
+        level_wise_builder.build(binned_features, byte_labels), expected_tree);
+}
+
+TEST(tree_builder_tests, test_build_binary)
+{
+    using namespace dtree;
+
+    auto features = tests::make_random_features(3, 500, 1u);
+    auto noise = tests::make_random_labels(500, 2, 2u);
+
+    labels test_labels;
+    for (std::size_t i = 0; i < 500; ++i)
+        test_labels.push_back(noise[i] + (features[0][i] > 0.5 ? 1u : 0u) > 0);
+
+    for (auto [presort, in_place] : { std::pair { false, false },
+             std::pair { true, false }, std::pair { false, true } }) {
+        tree_builder_config config { false, 0u, 4u, 5u, 0.95 };
+        config.presort = presort;
+        config.in_place = in_place;
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+        tree_builder binary_builder { config, algos::basic_optimal_split<2> {},
+            gini_impurity {} };
+
+        auto expected_tree = builder.build(features, test_labels);
+        auto tree = binary_builder.build(features, test_labels);
+        static_assert(std::is_same_v<decltype(tree)::leaf_type, binary_leaf>);
+
+        ASSERT_EQ(tree.data().size(), expected_tree.data().size());
+        for (std::size_t i = 0; i < tree.data().size(); ++i) {
+            ASSERT_EQ(tree[i].index(), expected_tree[i].index());
+            if (const auto* l = std::get_if<binary_leaf>(&tree[i])) {
+                const auto& expected = std::get<leaf>(expected_tree[i]).distribution();
+                EXPECT_DOUBLE_EQ(
+                    l->probability(), expected.size() > 1 ? expected[1] : 0.0);
+            } else {
+                tests::check_equal(std::get<0>(tree[i]), std::get<0>(expected_tree[i]));
+            }
+        }
+    }
+
+    tree_builder_config config { false, 0u, 4u, 5u, 0.95 };
+    tree_builder builder { config, algos::basic_optimal_split<2> {},
+        entropy_impurity {} };
+    EXPECT_THROW(builder.build(features, labels { 0u, 2u, 1u }), std::runtime_error);
+}
+
+TEST(tree_builder_tests, test_build_with_executor)
+{
+    using namespace dtree;
+
+    auto features = tests::make_random_features(4, 1000, 1u);
+    auto test_labels = tests::make_random_labels(1000, 2, 2u);
+
+    work_stealing_pool pool { 4 };
+
+    tree_builder_config config { false, 0u, 6u, 5u, 0.95 };
+    tree_builder builder { config, algos::optimal_split {}, gini_index };
+    auto expected_tree = builder.build(features, test_labels);
+
+    config.async = true;
+    config.executor_ = &pool;
+    for (bool in_place : { false, true }) {
+        config.in_place = in_place;
+        tree_builder pool_builder { config, algos::optimal_split {}, gini_index };
+        tests::check_equal(pool_builder.build(features, test_labels), expected_tree);
+    }
+}
+
+TEST(tree_builder_tests, test_build_with_parallel_features)
+{
+    using namespace dtree;
+
+    // rounded so that features tie and the chunks have to agree on the tie break
+    auto features = tests::make_random_features(7, 1000, 1u);
+    std::unordered_map<std::size_t, binned_feature> binned_features;
+    for (auto& [feature_id, feature] : features) {
+        for (auto& x : feature)
+            x = std::round(x);
+        binned_features.emplace(feature_id, make_binned_feature(feature));
+    }
+
+    auto test_labels = tests::make_random_labels(1000, 3, 2u);
+
+    work_stealing_pool pool { 3 };
+
+    for (bool async : { false, true }) {
+        tree_builder_config config { async, 0u, 5u, 5u, 0.95 };
+        tree_builder builder { config, algos::optimal_split {}, gini_index };
+        tree_builder histogram_builder { config, algos::histogram_split {},
+            gini_index };
+        auto expected_tree = builder.build(features, test_labels);
+        auto expected_histogram_tree
+            = histogram_builder.build(binned_features, test_labels);
+
+        config.parallel_features = true;
+        config.parallel_features_sample_min = 100u;
+        config.executor_ = &pool;
+        for (auto [presort, in_place] : { std::pair { false, false },
+                 std::pair { true, false }, std::pair { false, true } }) {
+            config.presort = presort;
+            config.in_place = in_place;
+            tree_builder parallel_builder { config, algos::optimal_split {},
+                gini_index };
+            tests::check_equal(
+                parallel_builder.build(features, test_labels), expected_tree);
+        }
+
+        tree_builder parallel_histogram_builder { config, algos::histogram_split {},
+            gini_index };
+        tests::check_equal(
+            parallel_histogram_builder.build(binned_features, test_labels),
+            expected_histogram_tree);
+    }
+}
+
 TEST(tree_builder_tests, test_build_with_multi_features)
 {
     spdlog::set_level(spdlog::level::debug);
@@ -193,6 +608,40 @@ TEST(tree_builder_test, test_build_with_string_features)
     auto tree = builder.build(feature_set, labels);
 }
 
+TEST(tree_builder_tests, test_build_with_categorical_features)
+{
+    using namespace dtree;
+
+    std::vector<std::string> methods { "GET", "POST", "GET", "PUT", "DELETE", "POST",
+        "GET", "DELETE" };
+    std::vector<std::string> statuses { "200", "403", "404", "200", "500", "200", "200",
+        "403" };
+    labels labels { 0u, 1u, 0u, 1u, 1u, 1u, 0u, 1u };
+
+    std::unordered_map<std::size_t, categorical_feature> feature_set {
+        { 0, make_categorical_feature(methods) },
+        { 1, make_categorical_feature(statuses) }
+    };
+
+    tree_builder builder { tree_builder_config { false, 0u, 2u, 1u, 1.0 },
+        algos::category_split {}, gini_index };
+
+    auto tree = builder.build(feature_set, labels);
+
+    // the GETs are the only requests labelled 0
+    auto post = make_categorical_feature(
+        std::vector<std::string> { "POST" }, feature_set[0].shared_dictionary());
+    auto get = make_categorical_feature(
+        std::vector<std::string> { "GET" }, feature_set[0].shared_dictionary());
+    auto ok = make_categorical_feature(
+        std::vector<std::string> { "200" }, feature_set[1].shared_dictionary());
+
+    std::vector<category> sample { get[0], ok[0] };
+    EXPECT_DOUBLE_EQ(tree.apply(sample)[0], 1.0);
+    sample[0] = post[0];
+    EXPECT_DOUBLE_EQ(tree.apply(sample)[1], 1.0);
+}
+
 TEST(tree_builder_tests, test_build_with_mixed_features)
 {
 
@@ -0,0 +1,81 @@
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <boost/archive/text_iarchive.hpp>
+
+#include "dtree/codegen.h"
+#include "dtree/flat_tree.h"
+#include "dtree/serialization.h"
+
+namespace {
+
+void usage()
+{
+    std::cerr << "usage: dtree_export_cpp <model> <header> [--binary] "
+                 "[--namespace <name>] [--function <name>]\n"
+                 "\n"
+                 "Writes a header scoring samples with the tree of single numeric\n"
+                 "splits serialized to <model> as a boost text archive. --binary\n"
+                 "reads a tree of binary_leaf rather than leaf.\n";
+}
+
+template <typename leaf_t>
+void export_tree(std::istream& model, std::ostream& header,
+    const dtree::codegen_config& config)
+{
+    dtree::flat_tree<dtree::node<dtree::single_numeric_splitting>, leaf_t> tree;
+    boost::archive::text_iarchive archive { model };
+    archive >> tree;
+    dtree::write_cpp(header, tree, config);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        usage();
+        return 1;
+    }
+
+    dtree::codegen_config config;
+    bool binary = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string_view arg { argv[i] };
+        if (arg == "--binary") {
+            binary = true;
+        } else if (arg == "--namespace" && i + 1 < argc) {
+            config.namespace_name = argv[++i];
+        } else if (arg == "--function" && i + 1 < argc) {
+            config.function_name = argv[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    std::ifstream model { argv[1] };
+    if (!model) {
+        std::cerr << "Couldn't open the model " << argv[1] << "\n";
+        return 1;
+    }
+    std::ofstream header { argv[2] };
+    if (!header) {
+        std::cerr << "Couldn't open the header " << argv[2] << "\n";
+        return 1;
+    }
+
+    try {
+        if (binary)
+            export_tree<dtree::binary_leaf>(model, header, config);
+        else
+            export_tree<dtree::leaf>(model, header, config);
+    } catch (const std::exception& e) {
+        std::cerr << "Couldn't export " << argv[1] << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}